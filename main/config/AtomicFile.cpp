@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "AtomicFile.h"
+
+#include <esp_log.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace config {
+static std::string tempPath(const std::string &path) { return path + ".tmp"; }
+
+static bool exists(const std::string &path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0;
+}
+
+bool writeFileAtomic(const std::string &path, const std::string &data) {
+    const std::string temp = tempPath(path);
+    {
+        std::ofstream f(temp, std::ios::binary | std::ios::trunc);
+        if (!f.is_open()) {
+            ESP_LOGE("Config", "Opening configuration file %s failed", temp.c_str());
+            return false;
+        }
+        f.write(data.data(), static_cast<std::streamsize>(data.size()));
+        f.close();
+        if (f.fail()) {
+            ESP_LOGE("Config", "Writing configuration file %s failed", temp.c_str());
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        ESP_LOGE("Config", "Renaming configuration file %s failed", temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void recoverFile(const std::string &path) {
+    const std::string temp = tempPath(path);
+    if (!exists(temp)) {
+        return;
+    }
+    if (exists(path)) {
+        // interrupted before the old file was removed, the temporary file may be incomplete
+        ESP_LOGW("Config", "Discarding incomplete configuration file %s", temp.c_str());
+        std::remove(temp.c_str());
+        return;
+    }
+    ESP_LOGW("Config", "Completing interrupted write of %s", path.c_str());
+    std::rename(temp.c_str(), path.c_str());
+}
+}  // namespace config
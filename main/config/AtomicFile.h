@@ -0,0 +1,43 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_ATOMICFILE_H
+#define SWITCHCONTROL_CONFIG_ATOMICFILE_H
+
+#include <string>
+
+namespace config {
+/**
+ * @brief Replace a file by writing a temporary file and renaming it.
+ * SPIFFS can't rename onto an existing file, so the old file is removed right before the rename. The file is
+ * either complete or missing with a complete temporary file next to it, which recoverFile() then picks up.
+ * @param path the file
+ * @param data the new content
+ * @return false if the file couldn't be written, the old content stays in place
+ */
+bool writeFileAtomic(const std::string &path, const std::string &data);
+
+/**
+ * @brief Finish or discard an interrupted writeFileAtomic(). Has to be called before reading the file.
+ * @param path the file
+ */
+void recoverFile(const std::string &path);
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_ATOMICFILE_H
@@ -19,21 +19,41 @@
 
 #include "ButtonConfig.h"
 
+#include "RouteConfig.h"
+
 namespace config {
 
 void to_json(nlohmann::json &j, const ConfigButton &ch) {
     j["actions"] = ch.actionOnPress;
     j["invertedInput"] = ch.invertedInput;
     j["invertedOutput"] = ch.invertedOutput;
+    if (!ch.route.empty()) {
+        j["route"] = ch.route;
+    }
+}
+
+void write_json(util::JsonWriter &w, const ConfigButton &ch) {
+    w.beginObject();
+    w.field("actions", ch.actionOnPress);
+    w.field("invertedInput", ch.invertedInput);
+    w.field("invertedOutput", ch.invertedOutput);
+    if (!ch.route.empty()) {
+        w.field("route", ch.route);
+    }
+    w.endObject();
 }
 
 void from_json(const nlohmann::json &j, ConfigButton &ch) {
     ch.actionOnPress = j.at("actions").get<std::vector<SwitchAction>>();
     ch.invertedInput = j.at("invertedInput").get<bool>();
     ch.invertedOutput = j.at("invertedOutput").get<bool>();
+    ch.route = j.value("route", "");
 }
 
 void ConfigButton::validate() const {
+    if (route.size() > kMaxRouteNameLength) {
+        throw std::runtime_error("Route name is invalid: " + route);
+    }
     for (const auto &item : actionOnPress) {
         item.validate();
     }
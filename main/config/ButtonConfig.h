@@ -29,11 +29,13 @@ class ConfigButton {
     bool invertedInput;
     bool invertedOutput;
     std::vector<SwitchAction> actionOnPress;  ///< Actions when the button is pressed
+    std::string route;                        ///< Named route set when the button is pressed, replaces the actions
 
     void validate() const;
 };
 
 void to_json(nlohmann::json &j, const ConfigButton &ch);
+void write_json(util::JsonWriter &w, const ConfigButton &ch);
 
 void from_json(const nlohmann::json &j, ConfigButton &ch);
 
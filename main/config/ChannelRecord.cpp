@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ChannelRecord.h"
+
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+#include <cinttypes>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "AtomicFile.h"
+#include "util/ByteBuffer.h"
+
+namespace config {
+static const inline uint32_t kRecordMagic = 0x46435753;  // "SWCF"
+static const inline uint16_t kRecordVersion = 3;
+static const inline size_t kHeaderSize = 20;
+static const inline std::array<const char *, 2> kRecordPaths = {"/spiffs/channels.0.bin", "/spiffs/channels.1.bin"};
+
+static const inline uint8_t kHasServo = 0x1;
+static const inline uint8_t kHasButton = 0x2;
+
+static void encodeServo(util::ByteWriter &w, const ConfigServo &s) {
+    w.u16(s.servoLeft);
+    w.u16(s.servoRight);
+    w.u16(s.servoOverdrawLeft);
+    w.u16(s.servoOverdrawRight);
+    w.u16(static_cast<uint16_t>(std::lround(s.overdrawTime * 1000)));
+    w.u8(s.rail);
+    w.u16(s.inrushCurrent);
+    w.u8(static_cast<uint8_t>(s.motionProfile));
+    w.u16(s.speed);
+    w.u8(static_cast<uint8_t>(s.sense));
+    w.u8(s.senseChannel);
+    w.u16(s.senseThreshold);
+    w.u16(s.senseLeft);
+    w.u16(s.senseRight);
+}
+
+static ConfigServo decodeServo(util::ByteReader &r, uint16_t version) {
+    ConfigServo s{};
+    s.servoLeft = r.u16();
+    s.servoRight = r.u16();
+    s.servoOverdrawLeft = r.u16();
+    s.servoOverdrawRight = r.u16();
+    s.overdrawTime = r.u16() / 1000.0;
+    s.rail = r.u8();
+    s.inrushCurrent = r.u16();
+    s.motionProfile = static_cast<MotionProfile>(static_cast<int8_t>(r.u8()));
+    s.speed = r.u16();
+    if (version >= 3) {
+        s.sense = static_cast<SenseMode>(static_cast<int8_t>(r.u8()));
+        s.senseChannel = r.u8();
+        s.senseThreshold = r.u16();
+        s.senseLeft = r.u16();
+        s.senseRight = r.u16();
+    }
+    return s;
+}
+
+static void encodeButton(util::ByteWriter &w, const ConfigButton &b) {
+    w.u8(b.invertedInput);
+    w.u8(b.invertedOutput);
+    w.u16(b.actionOnPress.size());
+    for (const auto &action : b.actionOnPress) {
+        w.u8(action.channel);
+        w.u8(static_cast<uint8_t>(action.direction));
+        w.u16(action.customTime);
+        w.str(action.ip);
+    }
+    w.str(b.route);
+}
+
+static ConfigButton decodeButton(util::ByteReader &r, uint16_t version) {
+    ConfigButton b{};
+    b.invertedInput = r.u8() != 0;
+    b.invertedOutput = r.u8() != 0;
+    size_t count = r.u16();
+    for (size_t i = 0; i < count; i++) {
+        SwitchAction action{};
+        action.channel = r.u8();
+        action.direction = static_cast<SwitchDirection>(static_cast<int8_t>(r.u8()));
+        action.customTime = r.u16();
+        action.ip = r.str();
+        b.actionOnPress.push_back(std::move(action));
+    }
+    if (version >= 2) {
+        b.route = r.str();
+    }
+    return b;
+}
+
+std::vector<uint8_t> encodeChannelRecord(const ChannelRecord &record) {
+    std::vector<uint8_t> payload;
+    util::ByteWriter p(payload);
+    for (const auto &ch : record.channels) {
+        p.u8(static_cast<uint8_t>(ch.type));
+        p.u8((ch.servoCfg_.has_value() ? kHasServo : 0) | (ch.buttonCfg_.has_value() ? kHasButton : 0));
+        if (ch.servoCfg_.has_value()) {
+            encodeServo(p, *ch.servoCfg_);
+        }
+        if (ch.buttonCfg_.has_value()) {
+            encodeButton(p, *ch.buttonCfg_);
+        }
+    }
+
+    std::vector<uint8_t> data;
+    data.reserve(kHeaderSize + payload.size());
+    util::ByteWriter h(data);
+    h.u32(kRecordMagic);
+    h.u16(kRecordVersion);
+    h.u8(kChannelCount);
+    h.u8(0);
+    h.u32(record.sequence);
+    h.u32(payload.size());
+    h.u32(esp_rom_crc32_le(0, payload.data(), payload.size()));
+    data.insert(data.end(), payload.begin(), payload.end());
+    return data;
+}
+
+std::optional<ChannelRecord> decodeChannelRecord(const std::vector<uint8_t> &data) {
+    try {
+        util::ByteReader h(data.data(), data.size());
+        if (h.u32() != kRecordMagic) {
+            return std::nullopt;
+        }
+        // version 1 records lack the route of buttons, version 2 records the sense input of servos
+        uint16_t version = h.u16();
+        if (version < 1 || version > kRecordVersion || h.u8() != kChannelCount) {
+            return std::nullopt;
+        }
+        h.u8();
+        ChannelRecord record{};
+        record.sequence = h.u32();
+        uint32_t length = h.u32();
+        uint32_t crc = h.u32();
+        if (data.size() - kHeaderSize != length || esp_rom_crc32_le(0, data.data() + kHeaderSize, length) != crc) {
+            return std::nullopt;
+        }
+
+        util::ByteReader r(data.data() + kHeaderSize, length);
+        for (ChannelId i = 0; i < kChannelCount; i++) {
+            ConfigGpio &ch = record.channels[i];
+            ch.channel = i;
+            ch.type = static_cast<ChannelType>(static_cast<int8_t>(r.u8()));
+            uint8_t flags = r.u8();
+            if (flags & kHasServo) {
+                ch.servoCfg_ = decodeServo(r, version);
+            }
+            if (flags & kHasButton) {
+                ch.buttonCfg_ = decodeButton(r, version);
+            }
+            try {
+                ch.validate();
+            } catch (const std::exception &e) {
+                ESP_LOGE("Config", "Stored configuration for channel %s is not valid: %s", channelName(i), e.what());
+                ch = ConfigGpio{};
+                ch.channel = i;
+            }
+        }
+        if (!r.done()) {
+            return std::nullopt;
+        }
+        return record;
+    } catch (const std::exception &e) {
+        return std::nullopt;
+    }
+}
+
+static std::optional<ChannelRecord> readSlot(const char *path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    auto record = decodeChannelRecord(data);
+    if (!record.has_value()) {
+        ESP_LOGW("Config", "Channel record %s is corrupted", path);
+    }
+    return record;
+}
+
+std::optional<ChannelRecord> readChannelRecord() {
+    std::optional<ChannelRecord> newest;
+    for (const char *path : kRecordPaths) {
+        recoverFile(path);
+        auto record = readSlot(path);
+        // compare with wrap around, the sequence is only ever incremented
+        if (record.has_value() && (!newest.has_value() || static_cast<int32_t>(record->sequence - newest->sequence) > 0)) {
+            newest = std::move(record);
+        }
+    }
+    if (newest.has_value()) {
+        ESP_LOGI("Config", "Loaded channel record %" PRIu32, newest->sequence);
+    }
+    return newest;
+}
+
+bool writeChannelRecord(const ChannelRecord &record) {
+    const char *path = kRecordPaths[record.sequence % kRecordPaths.size()];
+    ESP_LOGI("Config", "Storing channel record %" PRIu32 " to %s", record.sequence, path);
+    std::vector<uint8_t> data = encodeChannelRecord(record);
+    return writeFileAtomic(path, std::string(data.begin(), data.end()));
+}
+}  // namespace config
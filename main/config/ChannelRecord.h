@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_CHANNELRECORD_H
+#define SWITCHCONTROL_CONFIG_CHANNELRECORD_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "GpioConfig.h"
+
+namespace config {
+using ChannelTable = std::array<ConfigGpio, kChannelCount>;
+
+/**
+ * @brief The configuration of all channels as stored on flash.
+ * The record is stored in a packed binary format protected by a CRC. Two slots are written alternately, the
+ * sequence number decides which of two valid slots is the newer one. An interrupted write therefore always leaves
+ * the previous record intact.
+ */
+struct ChannelRecord {
+    uint32_t sequence{0};
+    ChannelTable channels{};
+};
+
+/**
+ * @brief Serialize a record including its header.
+ */
+std::vector<uint8_t> encodeChannelRecord(const ChannelRecord &record);
+
+/**
+ * @brief Deserialize a record.
+ * @return the record or nothing if the data is truncated, corrupted or of another version
+ */
+std::optional<ChannelRecord> decodeChannelRecord(const std::vector<uint8_t> &data);
+
+/**
+ * @brief Read the newest valid record from flash.
+ * @return the record or nothing if no slot holds a valid record
+ */
+std::optional<ChannelRecord> readChannelRecord();
+
+/**
+ * @brief Write a record to the slot selected by its sequence number.
+ * @return false if the record couldn't be written
+ */
+bool writeChannelRecord(const ChannelRecord &record);
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_CHANNELRECORD_H
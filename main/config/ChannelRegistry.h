@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_CHANNELREGISTRY_H
+#define SWITCHCONTROL_CONFIG_CHANNELREGISTRY_H
+
+#include <hal/ledc_types.h>
+#include <soc/gpio_num.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#define CAP_SMART_BUTTON (0x1 << 1)
+#define CAP_SERVO_OUT (0x1 << 2)
+#define CAP_I2C (0x1 << 3)
+#define CAP_SER_REM_IN (0x1 << 4)
+
+namespace config {
+/**
+ * @brief Index of a channel in the channel registry.
+ */
+using ChannelId = uint8_t;
+
+/**
+ * @brief Hardware resources of a single channel on the board.
+ */
+struct ChannelInfo {
+    const char *name;
+    gpio_num_t gpio;
+    ledc_channel_t ledc;  ///< LEDC channel for servo output, LEDC_CHANNEL_MAX if the channel can't drive a servo
+    int capabilities;
+};
+
+constexpr inline std::array<ChannelInfo, 16> kChannels = {{
+    {"A1", GPIO_NUM_25, LEDC_CHANNEL_0, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A2", GPIO_NUM_13, LEDC_CHANNEL_1, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A3", GPIO_NUM_23, LEDC_CHANNEL_2, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A4", GPIO_NUM_19, LEDC_CHANNEL_3, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A5", GPIO_NUM_18, LEDC_CHANNEL_4, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A6", GPIO_NUM_17, LEDC_CHANNEL_5, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A7", GPIO_NUM_16, LEDC_CHANNEL_6, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"A8", GPIO_NUM_4, LEDC_CHANNEL_7, CAP_SMART_BUTTON | CAP_SERVO_OUT},
+    {"B1", GPIO_NUM_22, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON | CAP_I2C},
+    {"B2", GPIO_NUM_21, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON | CAP_I2C},
+    {"B3", GPIO_NUM_32, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+    {"B4", GPIO_NUM_33, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+    {"B5", GPIO_NUM_26, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+    {"B6", GPIO_NUM_27, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+    {"B7", GPIO_NUM_14, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+    {"B8", GPIO_NUM_15, LEDC_CHANNEL_MAX, CAP_SMART_BUTTON},
+}};
+
+constexpr inline size_t kChannelCount = kChannels.size();
+
+/**
+ * @brief Resolve a channel by its user friendly name.
+ * @param name the name, e.g. "A1"
+ * @return the channel or nothing if the name is unknown
+ */
+constexpr std::optional<ChannelId> findChannel(std::string_view name) {
+    for (size_t i = 0; i < kChannelCount; i++) {
+        if (name == kChannels[i].name) {
+            return static_cast<ChannelId>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+constexpr bool isValidChannel(ChannelId id) { return id < kChannelCount; }
+
+/**
+ * @brief Get the name of a channel, safe to use with invalid ids.
+ */
+constexpr const char *channelName(ChannelId id) { return isValidChannel(id) ? kChannels[id].name : "invalid"; }
+
+static_assert(findChannel("A1") == 0 && findChannel("B8") == 15 && !findChannel("C1").has_value());
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_CHANNELREGISTRY_H
@@ -22,8 +22,11 @@
 #include <esp_log.h>
 #include <esp_spiffs.h>
 
+#include <bitset>
 #include <fstream>
 
+#include "util/EventLog.h"
+
 namespace config {
 static const inline std::string kStoragePath = "/spiffs";
 
@@ -60,14 +63,67 @@ void ConfigurationStorage::setup() {
     }
 }
 
-ConfigurationStorage::ConfigurationStorage() {
-    for (const auto &item : config::kGpioMap) {
-        channels_[item.first] = readGpio(item.first);
+ConfigurationStorage::ConfigurationStorage(PersistenceWorker &persistence) : persistence_(persistence) {
+    auto record = readChannelRecord();
+    if (record.has_value()) {
+        record_ = std::move(*record);
+        return;
+    }
+
+    ESP_LOGW("config", "No valid channel record stored, migrating json files or using defaults");
+    std::bitset<kChannelCount> migrated;
+    for (ChannelId i = 0; i < kChannelCount; i++) {
+        auto legacy = readLegacyGpio(i);
+        if (legacy.has_value()) {
+            record_.channels[i] = std::move(*legacy);
+            migrated.set(i);
+        }
+        record_.channels[i].channel = i;
+    }
+    if (!writeChannelRecord(record_)) {
+        ESP_LOGE("config", "Unable to store the channel record, keeping the json files");
+        return;
+    }
+
+    // the json files are only removed once the record can be read back, files which failed to parse are kept
+    auto stored = readChannelRecord();
+    if (!stored.has_value() || encodeChannelRecord(*stored) != encodeChannelRecord(record_)) {
+        ESP_LOGE("config", "Stored channel record doesn't match, keeping the json files");
+        return;
+    }
+    for (ChannelId i = 0; i < kChannelCount; i++) {
+        if (migrated.test(i)) {
+            removeLegacyGpio(i);
+        }
+    }
+}
+
+void ConfigurationStorage::setConfig(const config::ConfigGpio &conf) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        record_.channels[conf.channel] = conf;
+    }
+    util::events().record(util::EventType::eChannelConfig, conf.channel, static_cast<uint16_t>(conf.type));
+    persistence_.schedule(Document::eChannels, [this] { return persist(); });
+}
+
+bool ConfigurationStorage::persist() {
+    ChannelRecord record;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        record = record_;
+    }
+    // coalesced changes share a sequence number, so the other slot keeps the previous record
+    record.sequence++;
+    if (!writeChannelRecord(record)) {
+        return false;
     }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    record_.sequence = record.sequence;
+    return true;
 }
 
 std::vector<config::ConfigGpio> ConfigurationStorage::getChannels() {
-    auto kv = std::views::values(channels_);
-    return {kv.begin(), kv.end()};
+    return {record_.channels.begin(), record_.channels.end()};
 }
 }  // namespace config
\ No newline at end of file
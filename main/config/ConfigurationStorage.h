@@ -20,33 +20,44 @@
 #ifndef SWITCHCONTROL_CONFIG_CONFIGURATIONSTORAGE_H
 #define SWITCHCONTROL_CONFIG_CONFIGURATIONSTORAGE_H
 
+#include <array>
 #include <exception>
-#include <map>
+#include <mutex>
 #include <string>
 
+#include "ChannelRecord.h"
 #include "GpioConfig.h"
+#include "PersistenceWorker.h"
 #include "WiFiConfig.h"
 
 namespace config {
 
 class ConfigurationStorage {
    public:
-    explicit ConfigurationStorage();
+    explicit ConfigurationStorage(PersistenceWorker &persistence);
 
     static void setup();
 
-    [[nodiscard]] bool hasConfig(const std::string &channel) { return channels_.find(channel) != channels_.end(); }
+    /**
+     * @brief Update the configuration of a channel. All channels are stored as a new record by the persistence
+     * worker once the configuration is quiet.
+     */
+    void setConfig(const config::ConfigGpio &conf);
 
-    void setConfig(const std::string &key, const config::ConfigGpio &conf) {
-        channels_[key] = conf;
-        config::writeGpio(conf);
-    }
-
-    [[nodiscard]] const config::ConfigGpio &getConfig(const std::string &channel) { return channels_[channel]; }
+    [[nodiscard]] const config::ConfigGpio &getConfig(ChannelId channel) { return record_.channels[channel]; }
     [[nodiscard]] std::vector<config::ConfigGpio> getChannels();
 
    private:
-    std::map<std::string, config::ConfigGpio> channels_;
+    PersistenceWorker &persistence_;
+    // the worker task reads the record while the http server updates it
+    std::mutex mutex_;
+    config::ChannelRecord record_;
+
+    /**
+     * @brief Write the current record, the sequence only advances once the record is stored.
+     * @return false if the record couldn't be written
+     */
+    bool persist();
 };
 }  // namespace config
 
@@ -21,16 +21,17 @@
 
 #include <esp_log.h>
 
+#include <cstdio>
 #include <fstream>
 
 namespace config {
 
 gpio_num_t ConfigGpio::gpio() const {
-    if (kGpioMap.find(channel) == kGpioMap.end()) {
-        ESP_LOGE("Gpio", "Unknown gpio requested for channel %s", channel.c_str());
+    if (!isValidChannel(channel)) {
+        ESP_LOGE("Gpio", "Unknown gpio requested for channel %d", channel);
         return GPIO_NUM_0;
     }
-    return kGpioMap.find(channel)->second.gpio;
+    return kChannels[channel].gpio;
 }
 
 bool ConfigGpio::hasCapability() const {
@@ -50,12 +51,11 @@ bool ConfigGpio::hasCapability() const {
     }
     if (cap == 0) return true;
 
-    return (kGpioMap.find(channel)->second.capabilities & cap) != 0;
+    return (kChannels[channel].capabilities & cap) != 0;
 }
 
 void ConfigGpio::validate() const {
-    auto gpioEntry = kGpioMap.find(channel);
-    if (gpioEntry == kGpioMap.end()) {
+    if (!isValidChannel(channel)) {
         throw std::runtime_error("unknown gpio entry specified");
     }
 
@@ -84,7 +84,7 @@ void ConfigGpio::validate() const {
 }
 
 void to_json(nlohmann::json &j, const ConfigGpio &ch) {
-    j["channel"] = ch.channel;
+    j["channel"] = channelName(ch.channel);
     j["type"] = ch.type;
 
     if (ch.buttonCfg_) {
@@ -96,8 +96,21 @@ void to_json(nlohmann::json &j, const ConfigGpio &ch) {
     }
 }
 
+void write_json(util::JsonWriter &w, const ConfigGpio &ch) {
+    w.beginObject();
+    w.field("channel", channelName(ch.channel));
+    w.field("type", ch.type);
+    if (ch.buttonCfg_) {
+        w.field("button", *ch.buttonCfg_);
+    }
+    if (ch.servoCfg_) {
+        w.field("servo", *ch.servoCfg_);
+    }
+    w.endObject();
+}
+
 void from_json(const nlohmann::json &j, ConfigGpio &ch) {
-    j.at("channel").get_to(ch.channel);
+    ch.channel = channelFromJson(j.at("channel"));
     j.at("type").get_to(ch.type);
 
     if (j.count("button")) {
@@ -111,45 +124,33 @@ void from_json(const nlohmann::json &j, ConfigGpio &ch) {
 
 static const inline std::string kBasePath = "/spiffs/";
 
-config::ConfigGpio readGpio(const std::string &gpio) {
-    std::string path = kBasePath + gpio + ".json";
-    std::ifstream f(path);
+static std::string legacyPath(ChannelId channel) { return kBasePath + channelName(channel) + ".json"; }
+
+std::optional<config::ConfigGpio> readLegacyGpio(ChannelId channel) {
+    const char *gpio = channelName(channel);
+    std::ifstream f(legacyPath(channel));
     if (!f.is_open()) {
-        ESP_LOGW("Config", "Unable to read gpio configuration for %s, storing default", gpio.c_str());
-        config::ConfigGpio cfg{};
-        cfg.channel = gpio;
-        writeGpio(cfg);
-        return cfg;
+        return std::nullopt;
     }
 
-    ESP_LOGI("Config", "Reading stored configuration for gpio %s from disk", gpio.c_str());
+    ESP_LOGI("Config", "Migrating stored configuration for gpio %s", gpio);
 
+    std::optional<config::ConfigGpio> result;
     try {
         nlohmann::json json = nlohmann::json::parse(f);
-        f.close();
-        ESP_LOGI("Config", "Loaded '%s'", json.dump().c_str());
         config::ConfigGpio data = json;
+        if (data.channel != channel) {
+            throw std::runtime_error("stored configuration belongs to another channel");
+        }
         data.validate();
-        return data;
+        result = data;
     } catch (std::exception &e) {
-        ESP_LOGE("Config", "Stored configuration for channel %s is not valid: %s", gpio.c_str(), e.what());
-        config::ConfigGpio cfg{};
-        cfg.channel = gpio;
-        writeGpio(cfg);
-        return cfg;
-    }
-}
-
-void writeGpio(const config::ConfigGpio &cfg) {
-    ESP_LOGI("Config", "Storing new gpio configuration for %s", cfg.channel.c_str());
-    std::string path = kBasePath + cfg.channel + ".json";
-    std::ofstream f(path);
-    if (!f.is_open()) {
-        ESP_LOGE("Config", "Opening configuration file %s failed", path.c_str());
+        ESP_LOGE("Config", "Stored configuration for channel %s is not valid: %s", gpio, e.what());
     }
-    nlohmann::json j = cfg;
-    f << j << std::endl;
     f.close();
+    return result;
 }
 
+void removeLegacyGpio(ChannelId channel) { std::remove(legacyPath(channel).c_str()); }
+
 }  // namespace config
\ No newline at end of file
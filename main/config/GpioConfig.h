@@ -27,13 +27,9 @@
 #include <nlohmann/json.hpp>
 
 #include "ButtonConfig.h"
+#include "ChannelRegistry.h"
 #include "ServoConfig.h"
 
-#define CAP_SMART_BUTTON (0x1 << 1)
-#define CAP_SERVO_OUT (0x1 << 2)
-#define CAP_I2C (0x1 << 3)
-#define CAP_SER_REM_IN (0x1 << 4)
-
 namespace config {
 enum class ChannelType { eInvalid = -1, eDisabled = 0, eServo = 1, eSmartButton = 2, eI2c = 3 };
 
@@ -45,33 +41,9 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ChannelType, {
                                               {ChannelType::eI2c, "I2c"},
                                           })
 
-struct PinCapabilities {
-    gpio_num_t gpio;
-    int capabilities;
-};
-
-const static inline std::map<std::string, PinCapabilities> kGpioMap = {
-    {"A1", {GPIO_NUM_25, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A2", {GPIO_NUM_13, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A3", {GPIO_NUM_23, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A4", {GPIO_NUM_19, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A5", {GPIO_NUM_18, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A6", {GPIO_NUM_17, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A7", {GPIO_NUM_16, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"A8", {GPIO_NUM_4, CAP_SMART_BUTTON | CAP_SERVO_OUT}},
-    {"B1", {GPIO_NUM_22, CAP_SMART_BUTTON | CAP_I2C}},
-    {"B2", {GPIO_NUM_21, CAP_SMART_BUTTON | CAP_I2C}},
-    {"B3", {GPIO_NUM_32, CAP_SMART_BUTTON}},
-    {"B4", {GPIO_NUM_33, CAP_SMART_BUTTON}},
-    {"B5", {GPIO_NUM_26, CAP_SMART_BUTTON}},
-    {"B6", {GPIO_NUM_27, CAP_SMART_BUTTON}},
-    {"B7", {GPIO_NUM_14, CAP_SMART_BUTTON}},
-    {"B8", {GPIO_NUM_15, CAP_SMART_BUTTON}},
-};
-
 class ConfigGpio {
    public:
-    std::string channel{"0"};
+    ChannelId channel{0};
     ChannelType type{ChannelType::eDisabled};
 
     std::optional<config::ConfigButton> buttonCfg_;
@@ -85,11 +57,21 @@ class ConfigGpio {
 };
 
 void to_json(nlohmann::json &j, const ConfigGpio &ch);
+void write_json(util::JsonWriter &w, const ConfigGpio &ch);
 
 void from_json(const nlohmann::json &j, ConfigGpio &ch);
 
-config::ConfigGpio readGpio(const std::string &gpio);
+/**
+ * @brief Read a configuration stored as json file by older releases. The file is kept, see removeLegacyGpio().
+ * @param channel the channel
+ * @return the configuration or nothing if no valid configuration was stored
+ */
+std::optional<config::ConfigGpio> readLegacyGpio(ChannelId channel);
 
-void writeGpio(const config::ConfigGpio &cfg);
+/**
+ * @brief Delete the json file of a channel once its configuration is stored elsewhere.
+ * @param channel the channel
+ */
+void removeLegacyGpio(ChannelId channel);
 }  // namespace config
 #endif  // SWITCHCONTROL_CONFIG_GPIOCONFIG_H
@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PersistenceWorker.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+
+#include "util/EventLog.h"
+
+namespace config {
+
+const char *documentName(Document doc) {
+    switch (doc) {
+        case Document::eChannels:
+            return "channels";
+        case Document::eWiFi:
+            return "wifi";
+        case Document::ePower:
+            return "power";
+        case Document::eRoutes:
+            return "routes";
+        case Document::ePositions:
+            return "positions";
+    }
+    return "invalid";
+}
+
+PersistenceWorker::PersistenceWorker() {
+    // a flash write per move would wear the flash, the copy in RTC memory covers restarts
+    Slot &positions = slots_[static_cast<size_t>(Document::ePositions)];
+    positions.quietPeriod = kIdlePeriod;
+    positions.maxDeferral = std::chrono::milliseconds::zero();
+}
+
+void PersistenceWorker::schedule(Document doc, std::function<bool()> write) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        Slot &slot = slots_[static_cast<size_t>(doc)];
+        auto now = std::chrono::steady_clock::now();
+        if (slot.write) {
+            ESP_LOGD("Config", "Coalescing changes of %s", documentName(doc));
+        } else {
+            slot.firstChangeAt = now;
+        }
+        slot.write = std::move(write);
+        slot.changedAt = now;
+    }
+    TaskHandle_t task = task_.load();
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void PersistenceWorker::saveWiFi(const WiFiConfig &cfg) {
+    util::events().record(util::EventType::eConfigChange, util::kNoChannel, static_cast<uint16_t>(Document::eWiFi));
+    schedule(Document::eWiFi, [cfg] { return writeWiFi(cfg); });
+}
+
+void PersistenceWorker::savePower(const PowerConfig &cfg) {
+    util::events().record(util::EventType::eConfigChange, util::kNoChannel, static_cast<uint16_t>(Document::ePower));
+    schedule(Document::ePower, [cfg] { return writePower(cfg); });
+}
+
+void PersistenceWorker::saveRoutes(const RouteConfig &cfg) {
+    util::events().record(util::EventType::eConfigChange, util::kNoChannel, static_cast<uint16_t>(Document::eRoutes));
+    schedule(Document::eRoutes, [cfg] { return writeRoutes(cfg); });
+}
+
+bool PersistenceWorker::pending(Document doc) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const Slot &slot = slots_[static_cast<size_t>(doc)];
+    return slot.write || slot.writing;
+}
+
+void PersistenceWorker::flush() { writeDue(true); }
+
+std::chrono::steady_clock::time_point PersistenceWorker::writeDue(bool force) {
+    const std::lock_guard<std::mutex> writeLock(writeMutex_);
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (size_t i = 0; i < kDocumentCount; i++) {
+        std::function<bool()> write;
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            Slot &slot = slots_[i];
+            if (!slot.write) {
+                continue;
+            }
+            auto dueAt = slot.dueAt();
+            if (!force && std::chrono::steady_clock::now() < dueAt) {
+                next = std::min(next, dueAt);
+                continue;
+            }
+            write = std::move(slot.write);
+            slot.write = nullptr;
+            slot.writing = true;
+        }
+
+        ESP_LOGI("Config", "Persisting %s", documentName(static_cast<Document>(i)));
+        const bool written = write();
+
+        const std::lock_guard<std::mutex> lock(mutex_);
+        Slot &slot = slots_[i];
+        slot.writing = false;
+        if (written) {
+            slot.failures = 0;
+            slot.retryAt = {};
+        } else {
+            auto delay = std::min<std::chrono::milliseconds>(kRetryDelay * (1 << std::min(slot.failures, 5)),
+                                                             kMaxRetryDelay);
+            slot.failures++;
+            slot.retryAt = std::chrono::steady_clock::now() + delay;
+            ESP_LOGW("Config", "Persisting %s failed, retrying in %lld ms", documentName(static_cast<Document>(i)),
+                     static_cast<long long>(delay.count()));
+            if (!slot.write) {
+                // a newer change replaces the failed content, otherwise the failed write is retried
+                slot.write = std::move(write);
+                slot.changedAt = slot.firstChangeAt = std::chrono::steady_clock::now();
+            }
+        }
+        if (slot.write) {
+            // changed again while it was written or failed
+            next = std::min(next, slot.dueAt());
+        }
+    }
+    return next;
+}
+
+void PersistenceWorker::run() {
+    task_ = xTaskGetCurrentTaskHandle();
+    while (true) {
+        auto next = writeDue(false);
+        TickType_t timeout = portMAX_DELAY;
+        if (next != std::chrono::steady_clock::time_point::max()) {
+            auto delay = std::chrono::ceil<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+            // round up, waking early would only wait again
+            timeout = pdMS_TO_TICKS(std::max<int64_t>(delay.count(), 0)) + 1;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+}
+}  // namespace config
@@ -0,0 +1,136 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_PERSISTENCEWORKER_H
+#define SWITCHCONTROL_CONFIG_PERSISTENCEWORKER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "PowerConfig.h"
+#include "RouteConfig.h"
+#include "WiFiConfig.h"
+
+namespace config {
+/**
+ * @brief A configuration file written by the persistence worker.
+ */
+enum class Document { eChannels, eWiFi, ePower, eRoutes, ePositions };
+
+constexpr inline size_t kDocumentCount = 5;
+
+const char *documentName(Document doc);
+
+/**
+ * @brief Writes configurations to flash in a background task.
+ * Callers only mark a document dirty together with the function writing it. The write happens after the document
+ * didn't change for kQuietPeriod, so rapid edits from the UI result in a single flash write with the newest content.
+ * A document which keeps changing is written at the latest kMaxDeferral after its first unwritten change. A failed
+ * write keeps the document dirty and is retried with an increasing delay.
+ * The servo positions change with every move and are kept in RTC memory across restarts. Their flash copy is only
+ * written after kIdlePeriod without a move or by flush() before an orderly restart.
+ */
+class PersistenceWorker {
+   public:
+    static constexpr std::chrono::milliseconds kQuietPeriod{1000};
+    static constexpr std::chrono::milliseconds kMaxDeferral{5000};
+    static constexpr std::chrono::milliseconds kIdlePeriod{10 * 60 * 1000};
+    static constexpr std::chrono::milliseconds kRetryDelay{2000};
+    static constexpr std::chrono::milliseconds kMaxRetryDelay{60000};
+    const inline static int kTaskPriority = 2;
+    const inline static BaseType_t kTaskCore = 0;
+
+    PersistenceWorker();
+    PersistenceWorker(const PersistenceWorker &) = delete;
+    PersistenceWorker &operator=(const PersistenceWorker &) = delete;
+
+    /**
+     * @brief Mark a document dirty. A write which wasn't started yet is replaced. May be called from any task.
+     * @param doc the document
+     * @param write writes the newest content, called from the worker task, returns false if the write failed
+     */
+    void schedule(Document doc, std::function<bool()> write);
+
+    void saveWiFi(const WiFiConfig &cfg);
+    void savePower(const PowerConfig &cfg);
+    void saveRoutes(const RouteConfig &cfg);
+
+    /**
+     * @brief Check whether a document has changes which are not on flash yet.
+     */
+    [[nodiscard]] bool pending(Document doc);
+
+    /**
+     * @brief Write all dirty documents now in the calling task, e.g. before a restart.
+     */
+    void flush();
+
+    /**
+     * @brief Write the dirty documents in the calling task as soon as they are quiet.
+     */
+    [[noreturn]] void run();
+
+   private:
+    struct Slot {
+        std::function<bool()> write;
+        std::chrono::milliseconds quietPeriod{kQuietPeriod};
+        // no deferral limit if zero
+        std::chrono::milliseconds maxDeferral{kMaxDeferral};
+        std::chrono::steady_clock::time_point changedAt;
+        // first change which is not on flash yet
+        std::chrono::steady_clock::time_point firstChangeAt;
+        // earliest retry after failed writes
+        std::chrono::steady_clock::time_point retryAt;
+        int failures{0};
+        bool writing{false};
+
+        /**
+         * @brief Time the write is due, the document got quiet or was deferred for too long, but not before a retry.
+         */
+        [[nodiscard]] std::chrono::steady_clock::time_point dueAt() const {
+            auto due = changedAt + quietPeriod;
+            if (maxDeferral.count() > 0) {
+                due = std::min(due, firstChangeAt + maxDeferral);
+            }
+            return std::max(due, retryAt);
+        }
+    };
+
+    std::mutex mutex_;
+    std::array<Slot, kDocumentCount> slots_{};
+    // serializes the writes of the worker and flush()
+    std::mutex writeMutex_;
+    std::atomic<TaskHandle_t> task_{nullptr};
+
+    /**
+     * @brief Write all documents which are due or all dirty ones if forced.
+     * @return the time the next document is due, max if nothing is dirty
+     */
+    std::chrono::steady_clock::time_point writeDue(bool force);
+};
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_PERSISTENCEWORKER_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PositionStore.h"
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+#include <fstream>
+
+#include "AtomicFile.h"
+
+namespace config {
+static const inline std::string kPositionsPath = "/spiffs/positions.json";
+static const inline uint32_t kRetainedMagic = 0x53455256;
+
+/**
+ * @brief Positions kept in RTC memory, its content is random after a power cycle.
+ */
+struct RetainedPositions {
+    uint32_t magic;
+    uint32_t crc;
+    ServoPositions positions;
+};
+
+RTC_NOINIT_ATTR static RetainedPositions retained;
+
+static uint32_t retainedCrc() {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t *>(&retained.positions), sizeof(retained.positions));
+}
+
+static bool isValid(const ServoPosition &position) {
+    switch (position.direction) {
+        case SwitchDirection::eLeft:
+        case SwitchDirection::eRight:
+        case SwitchDirection::eUnknown:
+            return true;
+        case SwitchDirection::eCustom:
+            return isValidServoTime(position.time);
+        default:
+            return false;
+    }
+}
+
+static bool writePositions(const ServoPositions &positions) {
+    nlohmann::json j;
+    // called directly, the library's conversion of std::array would take precedence
+    to_json(j, positions);
+    return writeFileAtomic(kPositionsPath, j.dump());
+}
+
+ServoPositions PositionStore::restore() {
+    if (retained.magic == kRetainedMagic && retained.crc == retainedCrc()) {
+        ESP_LOGI("Config", "Restoring servo positions from RTC memory");
+        return retained.positions;
+    }
+
+    ServoPositions positions{};
+    recoverFile(kPositionsPath);
+    std::ifstream f(kPositionsPath);
+    if (f.is_open()) {
+        ESP_LOGI("Config", "Restoring servo positions from disk");
+        try {
+            from_json(nlohmann::json::parse(f), positions);
+        } catch (const std::exception &e) {
+            ESP_LOGW("Config", "Invalid servo positions stored, all servos are resynchronized: %s", e.what());
+            positions = {};
+        }
+    }
+    retained.positions = positions;
+    retained.crc = retainedCrc();
+    retained.magic = kRetainedMagic;
+    return positions;
+}
+
+void PositionStore::save(const ServoPositions &positions) {
+    retained.positions = positions;
+    retained.crc = retainedCrc();
+    retained.magic = kRetainedMagic;
+    persistence_.schedule(Document::ePositions, [positions] { return writePositions(positions); });
+}
+
+void to_json(nlohmann::json &j, const ServoPositions &positions) {
+    j = nlohmann::json::array();
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (positions[i].direction == SwitchDirection::eUnknown) {
+            continue;
+        }
+        nlohmann::json item = {{"channel", channelName(static_cast<ChannelId>(i))},
+                               {"position", positions[i].direction}};
+        if (positions[i].direction == SwitchDirection::eCustom) {
+            item["time"] = positions[i].time;
+        }
+        j.push_back(std::move(item));
+    }
+}
+
+void from_json(const nlohmann::json &j, ServoPositions &positions) {
+    positions = {};
+    for (const auto &item : j) {
+        ServoPosition position{item.at("position").get<SwitchDirection>(), item.value("time", 0)};
+        if (!isValid(position)) {
+            throw std::runtime_error("Servo position is invalid");
+        }
+        positions[channelFromJson(item.at("channel"))] = position;
+    }
+}
+}  // namespace config
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_POSITIONSTORE_H
+#define SWITCHCONTROL_CONFIG_POSITIONSTORE_H
+
+#include "PersistenceWorker.h"
+#include "ServoConfig.h"
+
+namespace config {
+/**
+ * @brief Keeps the last commanded position of each servo across restarts.
+ * The positions are held in RTC memory, which survives esp_restart() and is updated with every move. A copy on flash
+ * is written by the persistence worker once the servos were idle for a long time or before an orderly restart, it is
+ * used after a power cycle. Moves after the last flash write are lost by a power cycle.
+ */
+class PositionStore {
+   public:
+    explicit PositionStore(PersistenceWorker &persistence) : persistence_(persistence) {}
+
+    /**
+     * @brief Get the positions saved before the last restart.
+     * @return the positions, all unknown if nothing valid was saved
+     */
+    [[nodiscard]] ServoPositions restore();
+
+    /**
+     * @brief Save the positions of all servos.
+     */
+    void save(const ServoPositions &positions);
+
+   private:
+    PersistenceWorker &persistence_;
+};
+
+void to_json(nlohmann::json &j, const ServoPositions &positions);
+void from_json(const nlohmann::json &j, ServoPositions &positions);
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_POSITIONSTORE_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PowerConfig.h"
+
+#include <esp_log.h>
+
+#include <fstream>
+
+#include "AtomicFile.h"
+
+namespace config {
+static const inline std::string kPowerPath = "/spiffs/power.json";
+
+int PowerConfig::budget(int rail) const {
+    if (rail < 0 || rail >= static_cast<int>(rails.size())) {
+        // a rail which isn't configured is still limited, otherwise all of its servos would move at once
+        return PowerRailConfig{}.budget;
+    }
+    return rails[rail].budget;
+}
+
+void PowerConfig::validate() const {
+    if (rails.empty() || rails.size() > kMaxPowerRails) {
+        throw std::runtime_error("Number of power rails is invalid: " + std::to_string(rails.size()));
+    }
+    for (const auto &item : rails) {
+        if (item.budget <= 0 || item.budget > kMaxRailBudget) {
+            throw std::runtime_error("Power rail budget is invalid: " + std::to_string(item.budget));
+        }
+    }
+}
+
+config::PowerConfig readPower() {
+    recoverFile(kPowerPath);
+    std::ifstream f(kPowerPath);
+    if (!f.is_open()) {
+        ESP_LOGW("Config", "Unable to read power configuration, storing default");
+        config::PowerConfig cfg{};
+        writePower(cfg);
+        return cfg;
+    }
+    ESP_LOGI("Config", "Reading stored power configuration from disk");
+    try {
+        config::PowerConfig data = nlohmann::json::parse(f);
+        f.close();
+        data.validate();
+        return data;
+    } catch (const std::exception &e) {
+        ESP_LOGW("Config", "Invalid power configuration stored, resetting config.");
+        f.close();
+        config::PowerConfig cfg{};
+        writePower(cfg);
+        return cfg;
+    }
+}
+
+bool writePower(const config::PowerConfig &cfg) {
+    ESP_LOGI("Config", "Storing new power configuration");
+    nlohmann::json j = cfg;
+    return writeFileAtomic(kPowerPath, j.dump());
+}
+}  // namespace config
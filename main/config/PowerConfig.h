@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_POWERCONFIG_H
+#define SWITCHCONTROL_CONFIG_POWERCONFIG_H
+
+#include <nlohmann/json.hpp>
+#include <vector>
+
+namespace config {
+const static inline int kMaxPowerRails = 4;
+const static inline int kMaxRailBudget = 10000;
+
+/**
+ * @brief A power rail supplying a group of servos.
+ */
+struct PowerRailConfig {
+    int budget{1000};  ///< Current in mA which may be drawn by moving servos at the same time
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(PowerRailConfig, budget);
+
+struct PowerConfig {
+    std::vector<PowerRailConfig> rails{kMaxPowerRails};
+
+    /**
+     * @brief Current budget of a rail, rails which aren't configured get the default budget.
+     */
+    [[nodiscard]] int budget(int rail) const;
+
+    void validate() const;
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(PowerConfig, rails);
+
+config::PowerConfig readPower();
+
+bool writePower(const config::PowerConfig &cfg);
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_POWERCONFIG_H
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RouteConfig.h"
+
+#include <esp_log.h>
+
+#include <fstream>
+
+#include "AtomicFile.h"
+
+namespace config {
+static const inline std::string kRoutesPath = "/spiffs/routes.json";
+
+void to_json(nlohmann::json &j, const ConfigRoute &route) {
+    j["name"] = route.name;
+    j["actions"] = route.actions;
+}
+
+void from_json(const nlohmann::json &j, ConfigRoute &route) {
+    route.name = j.at("name").get<std::string>();
+    route.actions = j.at("actions").get<std::vector<SwitchAction>>();
+}
+
+void ConfigRoute::validate() const {
+    if (name.empty() || name.size() > kMaxRouteNameLength) {
+        throw std::runtime_error("Route name is invalid: " + name);
+    }
+    if (actions.empty()) {
+        throw std::runtime_error("Route " + name + " has no actions.");
+    }
+    for (const auto &item : actions) {
+        item.validate();
+    }
+}
+
+std::optional<size_t> RouteConfig::find(std::string_view name) const {
+    for (size_t i = 0; i < routes.size(); i++) {
+        if (routes[i].name == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+void RouteConfig::validate() const {
+    if (routes.size() > kMaxRoutes) {
+        throw std::runtime_error("Too many routes: " + std::to_string(routes.size()));
+    }
+    for (size_t i = 0; i < routes.size(); i++) {
+        routes[i].validate();
+        if (find(routes[i].name) != i) {
+            throw std::runtime_error("Route name is used twice: " + routes[i].name);
+        }
+    }
+}
+
+config::RouteConfig readRoutes() {
+    recoverFile(kRoutesPath);
+    std::ifstream f(kRoutesPath);
+    if (!f.is_open()) {
+        ESP_LOGI("Config", "No routes stored");
+        return {};
+    }
+    ESP_LOGI("Config", "Reading stored routes from disk");
+    try {
+        config::RouteConfig data = nlohmann::json::parse(f);
+        f.close();
+        data.validate();
+        return data;
+    } catch (const std::exception &e) {
+        ESP_LOGW("Config", "Invalid routes stored, ignoring them: %s", e.what());
+        f.close();
+        return {};
+    }
+}
+
+bool writeRoutes(const config::RouteConfig &cfg) {
+    ESP_LOGI("Config", "Storing %zu routes", cfg.routes.size());
+    nlohmann::json j = cfg;
+    return writeFileAtomic(kRoutesPath, j.dump());
+}
+}  // namespace config
@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONFIG_ROUTECONFIG_H
+#define SWITCHCONTROL_CONFIG_ROUTECONFIG_H
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "ServoConfig.h"
+
+namespace config {
+const static inline size_t kMaxRoutes = 32;
+const static inline size_t kMaxRouteNameLength = 32;
+
+/**
+ * @brief A named set of switch changes, e.g. all turnouts between two signals.
+ */
+struct ConfigRoute {
+    std::string name;
+    std::vector<SwitchAction> actions;
+
+    void validate() const;
+};
+
+void to_json(nlohmann::json &j, const ConfigRoute &route);
+void from_json(const nlohmann::json &j, ConfigRoute &route);
+
+struct RouteConfig {
+    std::vector<ConfigRoute> routes;
+
+    /**
+     * @brief Get the index of a route.
+     * @param name the name of the route
+     * @return the index or nothing if no route with this name exists
+     */
+    [[nodiscard]] std::optional<size_t> find(std::string_view name) const;
+
+    void validate() const;
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(RouteConfig, routes);
+
+config::RouteConfig readRoutes();
+
+bool writeRoutes(const config::RouteConfig &cfg);
+}  // namespace config
+
+#endif  // SWITCHCONTROL_CONFIG_ROUTECONFIG_H
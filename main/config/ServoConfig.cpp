@@ -19,7 +19,7 @@
 
 #include "ServoConfig.h"
 
-#include "GpioConfig.h"
+#include "PowerConfig.h"
 
 namespace config {
 void to_json(nlohmann::json &j, const ConfigServo &ch) {
@@ -28,6 +28,34 @@ void to_json(nlohmann::json &j, const ConfigServo &ch) {
     j["posLeftOverdraw"] = ch.servoOverdrawLeft;
     j["posRightOverdraw"] = ch.servoOverdrawRight;
     j["overdrawTime"] = ch.overdrawTime;
+    j["rail"] = ch.rail;
+    j["inrushCurrent"] = ch.inrushCurrent;
+    j["motionProfile"] = ch.motionProfile;
+    j["speed"] = ch.speed;
+    j["sense"] = ch.sense;
+    j["senseChannel"] = ch.senseChannel;
+    j["senseThreshold"] = ch.senseThreshold;
+    j["senseLeft"] = ch.senseLeft;
+    j["senseRight"] = ch.senseRight;
+}
+
+void write_json(util::JsonWriter &w, const ConfigServo &ch) {
+    w.beginObject();
+    w.field("posLeft", ch.servoLeft);
+    w.field("posRight", ch.servoRight);
+    w.field("posLeftOverdraw", ch.servoOverdrawLeft);
+    w.field("posRightOverdraw", ch.servoOverdrawRight);
+    w.field("overdrawTime", ch.overdrawTime);
+    w.field("rail", ch.rail);
+    w.field("inrushCurrent", ch.inrushCurrent);
+    w.field("motionProfile", ch.motionProfile);
+    w.field("speed", ch.speed);
+    w.field("sense", ch.sense);
+    w.field("senseChannel", ch.senseChannel);
+    w.field("senseThreshold", ch.senseThreshold);
+    w.field("senseLeft", ch.senseLeft);
+    w.field("senseRight", ch.senseRight);
+    w.endObject();
 }
 
 void from_json(const nlohmann::json &j, ConfigServo &ch) {
@@ -36,6 +64,15 @@ void from_json(const nlohmann::json &j, ConfigServo &ch) {
     ch.servoOverdrawLeft = j.at("posLeftOverdraw").get<int>();
     ch.servoOverdrawRight = j.at("posRightOverdraw").get<int>();
     ch.overdrawTime = j.at("overdrawTime").get<double>();
+    ch.rail = j.value("rail", ConfigServo{}.rail);
+    ch.inrushCurrent = j.value("inrushCurrent", ConfigServo{}.inrushCurrent);
+    ch.motionProfile = j.value("motionProfile", ConfigServo{}.motionProfile);
+    ch.speed = j.value("speed", ConfigServo{}.speed);
+    ch.sense = j.value("sense", ConfigServo{}.sense);
+    ch.senseChannel = j.value("senseChannel", ConfigServo{}.senseChannel);
+    ch.senseThreshold = j.value("senseThreshold", ConfigServo{}.senseThreshold);
+    ch.senseLeft = j.value("senseLeft", ConfigServo{}.senseLeft);
+    ch.senseRight = j.value("senseRight", ConfigServo{}.senseRight);
 }
 
 void ConfigServo::validate() const {
@@ -54,28 +91,164 @@ void ConfigServo::validate() const {
     if (overdrawTime < 0 || overdrawTime > 5) {
         throw std::runtime_error("Overdraw time invalid: " + std::to_string(overdrawTime));
     }
+    if (rail < 0 || rail >= kMaxPowerRails) {
+        throw std::runtime_error("Power rail invalid: " + std::to_string(rail));
+    }
+    if (inrushCurrent < 0 || inrushCurrent > kMaxInrushCurrent) {
+        throw std::runtime_error("Inrush current invalid: " + std::to_string(inrushCurrent));
+    }
+    if (motionProfile == MotionProfile::eInvalid) {
+        throw std::runtime_error("Motion profile invalid.");
+    }
+    if (speed < kMinServoSpeed || speed > kMaxServoSpeed) {
+        throw std::runtime_error("Servo speed invalid: " + std::to_string(speed));
+    }
+    if (sense == SenseMode::eInvalid) {
+        throw std::runtime_error("Sense mode invalid.");
+    }
+    if (senseChannel < 0 || senseChannel > kMaxSenseChannel) {
+        throw std::runtime_error("Sense channel invalid: " + std::to_string(senseChannel));
+    }
+    if (senseThreshold <= 0 || senseThreshold > kMaxSenseMillivolts) {
+        throw std::runtime_error("Sense threshold invalid: " + std::to_string(senseThreshold));
+    }
+    if (senseLeft < 0 || senseLeft > kMaxSenseMillivolts || senseRight < 0 || senseRight > kMaxSenseMillivolts) {
+        throw std::runtime_error("Sense position invalid.");
+    }
 }
 
 bool isValidServoTime(int time) {
     return time >= kMinServoTime && time <= kMaxServoTime;
 }
 
+ChannelId channelFromJson(const nlohmann::json &j) {
+    auto channel = findChannel(j.get<std::string>());
+    if (!channel.has_value()) {
+        throw std::runtime_error("Provided channel is invalid.");
+    }
+    return *channel;
+}
+
 void to_json(nlohmann::json &j, const SwitchAction &a) {
-    j["channel"] = a.channel;
+    j["channel"] = channelName(a.channel);
     j["direction"] = a.direction;
     if (!a.ip.empty()) j["ip"] = a.ip;
     if (a.customTime != 0) j["time"] = a.customTime;
 }
 
+void write_json(util::JsonWriter &w, const SwitchAction &a) {
+    w.beginObject();
+    w.field("channel", channelName(a.channel));
+    w.field("direction", a.direction);
+    if (!a.ip.empty()) w.field("ip", a.ip);
+    if (a.customTime != 0) w.field("time", a.customTime);
+    w.endObject();
+}
+
 void from_json(const nlohmann::json &j, SwitchAction &a) {
-    a.channel = j.at("channel").get<std::string>();
+    a.channel = channelFromJson(j.at("channel"));
     a.direction = j.at("direction").get<SwitchDirection>();
     if (j.count("ip")) a.ip = j.at("ip").get<std::string>();
     if (j.count("time")) a.customTime = j.at("time").get<int>();
 }
 
+bool SwitchActionReader::fail(const std::string &msg) {
+    if (error_.empty()) {
+        error_ = msg;
+    }
+    return false;
+}
+
+bool SwitchActionReader::value() {
+    // values of unknown fields are skipped, known fields need another type
+    if (depth_ == 1 && (key_ == "channel" || key_ == "direction" || key_ == "ip" || key_ == "time")) {
+        return fail("Invalid type of field " + key_);
+    }
+    return depth_ > 0 || fail("Action has to be an object");
+}
+
+bool SwitchActionReader::number(number_integer_t val) {
+    if (depth_ == 1 && key_ == "time") {
+        action_.customTime = static_cast<int>(val);
+        return true;
+    }
+    return value();
+}
+
+bool SwitchActionReader::string(string_t &val) {
+    if (depth_ != 1) {
+        return value();
+    }
+    if (key_ == "channel") {
+        auto channel = findChannel(val);
+        if (!channel.has_value()) {
+            return fail("Provided channel is invalid.");
+        }
+        action_.channel = *channel;
+        hasChannel_ = true;
+        return true;
+    }
+    if (key_ == "direction") {
+        action_.direction = nlohmann::json(val).get<SwitchDirection>();
+        hasDirection_ = true;
+        return true;
+    }
+    if (key_ == "ip") {
+        action_.ip = std::move(val);
+        return true;
+    }
+    return value();
+}
+
+bool SwitchActionReader::start_object(std::size_t) {
+    if (depth_ == 1 && !value()) {
+        return false;
+    }
+    depth_++;
+    return true;
+}
+
+bool SwitchActionReader::key(string_t &val) {
+    if (depth_ == 1) {
+        key_ = std::move(val);
+    }
+    return true;
+}
+
+bool SwitchActionReader::end_object() {
+    depth_--;
+    return true;
+}
+
+bool SwitchActionReader::start_array(std::size_t) {
+    if (!value()) {
+        return false;
+    }
+    depth_++;
+    return true;
+}
+
+bool SwitchActionReader::end_array() {
+    depth_--;
+    return true;
+}
+
+bool SwitchActionReader::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) {
+    return fail(ex.what());
+}
+
+SwitchAction SwitchActionReader::result() const {
+    if (!error_.empty()) {
+        throw std::runtime_error(error_);
+    }
+    if (!hasChannel_ || !hasDirection_) {
+        throw std::runtime_error("Action requires channel and direction");
+    }
+    return action_;
+}
+
 void SwitchAction::validate() const {
-    if (config::kGpioMap.find(channel) == config::kGpioMap.end()) {
+    if (!isValidChannel(channel)) {
         throw std::runtime_error("Provided channel is invalid.");
     }
 
@@ -20,12 +20,46 @@
 #ifndef SWITCHCONTROL_CONFIG_SERVOCONFIG_H
 #define SWITCHCONTROL_CONFIG_SERVOCONFIG_H
 
+#include <array>
 #include <nlohmann/json.hpp>
 #include <string>
 
+#include "ChannelRegistry.h"
+#include "util/JsonWriter.h"
+
 namespace config {
 const static inline int kMinServoTime = 800;
 const static inline int kMaxServoTime = 2200;
+const static inline int kMaxInrushCurrent = 5000;
+const static inline int kMinServoSpeed = 50;
+const static inline int kMaxServoSpeed = 20000;
+const static inline int kMaxSenseChannel = 7;
+const static inline int kMaxSenseMillivolts = 3300;
+
+/**
+ * @brief Shape of the pulse width ramp while a servo moves.
+ */
+enum class MotionProfile { eInvalid = -1, eNone = 0, eLinear = 1, eTrapezoidal = 2, eSCurve = 3 };
+
+NLOHMANN_JSON_SERIALIZE_ENUM(MotionProfile, {
+                                                {MotionProfile::eInvalid, nullptr},
+                                                {MotionProfile::eNone, "None"},
+                                                {MotionProfile::eLinear, "Linear"},
+                                                {MotionProfile::eTrapezoidal, "Trapezoidal"},
+                                                {MotionProfile::eSCurve, "SCurve"},
+                                            })
+
+/**
+ * @brief Feedback input of a servo which ends the overdraw as soon as the turnout is in position.
+ */
+enum class SenseMode { eInvalid = -1, eNone = 0, eCurrent = 1, ePosition = 2 };
+
+NLOHMANN_JSON_SERIALIZE_ENUM(SenseMode, {
+                                            {SenseMode::eInvalid, nullptr},
+                                            {SenseMode::eNone, "None"},
+                                            {SenseMode::eCurrent, "Current"},
+                                            {SenseMode::ePosition, "Position"},
+                                        })
 
 class ConfigServo {
    public:
@@ -34,6 +68,15 @@ class ConfigServo {
     int servoOverdrawLeft{1250};    ///< Time in us for left overdraw position
     int servoOverdrawRight{1750};  ///< Time in us for right overdraw position
     double overdrawTime{0.2};      ///< Time in seconds to overdraw
+    int rail{0};                   ///< Power rail supplying this servo
+    int inrushCurrent{500};        ///< Estimated current in mA drawn while the servo moves
+    MotionProfile motionProfile{MotionProfile::eNone};  ///< Ramp used to move the servo, eNone jumps to the target
+    int speed{1000};                                    ///< Average speed of a ramp in us pulse width per second
+    SenseMode sense{SenseMode::eNone};                  ///< Feedback input ending the overdraw early
+    int senseChannel{0};                                ///< ADC1 channel of the feedback input
+    int senseThreshold{500};  ///< Current: reading in mV of a stalled servo. Position: tolerance in mV
+    int senseLeft{0};         ///< Position: reading in mV in the left position
+    int senseRight{0};        ///< Position: reading in mV in the right position
 
     void validate() const;
 };
@@ -51,7 +94,7 @@ NLOHMANN_JSON_SERIALIZE_ENUM(SwitchDirection, {
 class SwitchAction {
    public:
     std::string ip{};
-    std::string channel{"0"};
+    ChannelId channel{0};
     SwitchDirection direction{SwitchDirection::eUnknown};
     int customTime{1500};
 
@@ -60,10 +103,70 @@ class SwitchAction {
 
 bool isValidServoTime(int time);
 
+/**
+ * @brief The last commanded position of a servo, restored after a restart.
+ */
+struct ServoPosition {
+    SwitchDirection direction{SwitchDirection::eUnknown};
+    int time{0};  ///< pulse width in us of a custom position
+};
+
+/**
+ * @brief Positions of all servos, indexed by their channel.
+ */
+using ServoPositions = std::array<ServoPosition, kChannelCount>;
+
+/**
+ * @brief Resolve a channel name stored in json.
+ * @throws std::runtime_error if the channel is unknown
+ */
+ChannelId channelFromJson(const nlohmann::json &j);
+
 void to_json(nlohmann::json &j, const ConfigServo &ch);
+void write_json(util::JsonWriter &w, const ConfigServo &ch);
 void from_json(const nlohmann::json &j, ConfigServo &ch);
 
+/**
+ * @brief SAX handler decoding a SwitchAction without building a json document.
+ * Accepts the same fields as from_json, unknown fields are skipped.
+ */
+class SwitchActionReader : public nlohmann::json::json_sax_t {
+   public:
+    bool null() override { return value(); }
+    bool boolean(bool) override { return value(); }
+    bool number_integer(number_integer_t val) override { return number(val); }
+    bool number_unsigned(number_unsigned_t val) override { return number(static_cast<number_integer_t>(val)); }
+    bool number_float(number_float_t, const string_t &) override { return value(); }
+    bool string(string_t &val) override;
+    bool binary(binary_t &) override { return value(); }
+    bool start_object(std::size_t) override;
+    bool key(string_t &val) override;
+    bool end_object() override;
+    bool start_array(std::size_t) override;
+    bool end_array() override;
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) override;
+
+    /**
+     * @brief Get the decoded action.
+     * @throws std::runtime_error if the document was invalid or required fields are missing
+     */
+    [[nodiscard]] SwitchAction result() const;
+
+   private:
+    bool value();
+    bool number(number_integer_t val);
+    bool fail(const std::string &msg);
+
+    SwitchAction action_{};
+    std::string key_;
+    int depth_{0};
+    bool hasChannel_{false};
+    bool hasDirection_{false};
+    std::string error_;
+};
+
 void to_json(nlohmann::json &j, const SwitchAction &a);
+void write_json(util::JsonWriter &w, const SwitchAction &a);
 void from_json(const nlohmann::json &j, SwitchAction &a);
 }  // namespace config
 
@@ -23,10 +23,13 @@
 
 #include <fstream>
 
+#include "AtomicFile.h"
+
 namespace config {
 static const inline std::string kWiFiPath = "/spiffs/wifi.json";
 
 config::WiFiConfig readWiFi() {
+    recoverFile(kWiFiPath);
     std::ifstream f(kWiFiPath);
     if (!f.is_open()) {
         ESP_LOGW("Config", "Unable to read wifi configuration, storing default");
@@ -48,15 +51,10 @@ config::WiFiConfig readWiFi() {
     }
 }
 
-void writeWiFi(const config::WiFiConfig &cfg) {
+bool writeWiFi(const config::WiFiConfig &cfg) {
     ESP_LOGI("Config", "Storing new wifi configuration");
-    std::ofstream f(kWiFiPath);
-    if (!f.is_open()) {
-        ESP_LOGE("Config", "Opening configuration file %s failed", kWiFiPath.c_str());
-    }
     nlohmann::json j = cfg;
-    f << j << std::endl;
-    f.close();
+    return writeFileAtomic(kWiFiPath, j.dump());
 }
 bool WiFiConfig::operator==(const WiFiConfig &rhs) const {
     return mode == rhs.mode && hostname == rhs.hostname && sta == rhs.sta && ap == rhs.ap;
@@ -90,7 +90,7 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(WiFiConfig, mode, hostname, sta, ap);
 
 config::WiFiConfig readWiFi();
 
-void writeWiFi(const config::WiFiConfig &cfg);
+bool writeWiFi(const config::WiFiConfig &cfg);
 }  // namespace config
 
 #endif  // SWITCHCONTROL_CONFIG_WIFICONFIG_H
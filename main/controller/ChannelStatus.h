@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_CHANNELSTATUS_H
+#define SWITCHCONTROL_CONTROLLER_CHANNELSTATUS_H
+
+#include <array>
+#include <nlohmann/json.hpp>
+#include <optional>
+
+#include "PendingQueue.h"
+#include "config/ChannelRegistry.h"
+#include "io/ServoOutChannel.h"
+
+namespace controller {
+/**
+ * @brief Published state of a single channel, a channel without a servo is not present.
+ */
+struct ChannelStatus {
+    std::optional<io::ServoStatus> servo{};
+    std::optional<Priority> priority{};  ///< priority class of the pending action
+
+    bool operator==(const ChannelStatus &) const = default;
+};
+
+/**
+ * @brief Published state of all channels, indexed by the channel.
+ */
+using StatusTable = std::array<ChannelStatus, config::kChannelCount>;
+
+/**
+ * @brief Serialize the state of a present channel.
+ */
+void to_json(nlohmann::json &j, const ChannelStatus &status);
+
+/**
+ * @brief Serialize all present channels into a json array.
+ */
+nlohmann::json statusToJson(const StatusTable &table);
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_CHANNELSTATUS_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_COMMAND_H
+#define SWITCHCONTROL_CONTROLLER_COMMAND_H
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "config/GpioConfig.h"
+#include "config/PowerConfig.h"
+#include "config/RouteConfig.h"
+#include "config/ServoConfig.h"
+#include "ChannelStatus.h"
+#include "PendingQueue.h"
+#include "RouteTracker.h"
+
+namespace controller {
+/**
+ * @brief Queue changes of switches, they are performed as soon as the power budget allows it.
+ */
+struct RequestSwitchChange {
+    std::vector<config::SwitchAction> actions;
+    RouteId route{0};  ///< route tracking the completion of the changes, 0 if not tracked
+    Priority priority{Priority::eRemote};
+};
+
+/**
+ * @brief Move a single servo immediately, bypassing the pending changes.
+ */
+struct ForceSwitchChange {
+    config::SwitchAction action;
+};
+
+/**
+ * @brief Add or replace the configuration of a channel.
+ */
+struct UpdateChannel {
+    config::ConfigGpio cfg;
+};
+
+/**
+ * @brief Replace the budgets of the power rails.
+ */
+struct SetPowerConfig {
+    config::PowerConfig cfg;
+};
+
+/**
+ * @brief Replace all named routes.
+ */
+struct SetRoutes {
+    config::RouteConfig cfg;
+};
+
+/**
+ * @brief Lock a named route and move its servos or release the lock.
+ */
+struct LockRoute {
+    std::string name;
+    bool locked;
+    RouteId route{0};  ///< route tracking the completion of the changes, 0 if not tracked
+};
+
+/**
+ * @brief Set the positions servos start in when their channel is added, e.g. the positions before a restart.
+ */
+struct RestorePositions {
+    config::ServoPositions positions;
+};
+
+/**
+ * @brief A command sent to the control loop. The control loop is the only owner of the channel state, all other
+ * tasks only communicate with it through commands.
+ */
+using Command = std::variant<std::monostate, RequestSwitchChange, ForceSwitchChange, UpdateChannel, SetPowerConfig,
+                             SetRoutes, LockRoute, RestorePositions>;
+
+/**
+ * @brief Changed state of a single channel, serialized by the notifier task.
+ */
+struct StatusDelta {
+    config::ChannelId channel{0};
+    ChannelStatus status{};
+};
+
+/**
+ * @brief Actions to forward to another board. They have their own queue, so a burst of status changes can't push
+ * them out.
+ */
+struct RemoteActions {
+    std::string peer;
+    std::vector<config::SwitchAction> actions;
+};
+
+/**
+ * @brief The commanded positions of all servos after one of them changed.
+ */
+struct PositionChange {
+    config::ServoPositions positions;
+};
+
+/**
+ * @brief A notification sent by the control loop. Notifications are delivered by a task of the network side, so the
+ * control loop never waits for a socket.
+ */
+using Notification = std::variant<std::monostate, StatusDelta, PositionChange>;
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_COMMAND_H
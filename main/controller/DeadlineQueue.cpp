@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "DeadlineQueue.h"
+
+namespace controller {
+
+void DeadlineQueue::schedule(std::chrono::steady_clock::time_point at, DeadlineType type,
+                             config::ChannelId channel) {
+    heap_.push({at, type, channel});
+}
+
+std::optional<Deadline> DeadlineQueue::popDue(std::chrono::steady_clock::time_point now) {
+    if (heap_.empty() || heap_.top().at > now) {
+        return std::nullopt;
+    }
+    Deadline d = heap_.top();
+    heap_.pop();
+    return d;
+}
+
+std::optional<std::chrono::steady_clock::time_point> DeadlineQueue::next() const {
+    if (heap_.empty()) {
+        return std::nullopt;
+    }
+    return heap_.top().at;
+}
+}  // namespace controller
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_DEADLINEQUEUE_H
+#define SWITCHCONTROL_CONTROLLER_DEADLINEQUEUE_H
+
+#include <chrono>
+#include <optional>
+#include <queue>
+#include <vector>
+
+#include "config/ChannelRegistry.h"
+
+namespace controller {
+enum class DeadlineType { eMoveFinished = 0, eOverdrawRelease = 1, eMotionStep = 2, eStatusRetry = 3 };
+
+/**
+ * @brief A point in time at which the controller has to do some work.
+ */
+struct Deadline {
+    std::chrono::steady_clock::time_point at;
+    DeadlineType type;
+    config::ChannelId channel;
+
+    bool operator>(const Deadline &rhs) const { return at > rhs.at; }
+};
+
+/**
+ * @brief Min-heap of deadlines ordered by their due time.
+ * Deadlines are never removed early, the consumer has to check whether a popped deadline is still relevant.
+ */
+class DeadlineQueue {
+   public:
+    void schedule(std::chrono::steady_clock::time_point at, DeadlineType type, config::ChannelId channel = 0);
+
+    /**
+     * @brief Pop the earliest deadline if it is due.
+     * @param now the current time
+     * @return the due deadline or nothing if no deadline is due yet
+     */
+    std::optional<Deadline> popDue(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Get the time of the earliest deadline.
+     */
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> next() const;
+
+    [[nodiscard]] size_t size() const { return heap_.size(); }
+
+   private:
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> heap_;
+};
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_DEADLINEQUEUE_H
@@ -20,122 +20,741 @@
 
 #include "OperationController.h"
 
-#include <driver/gpio.h>
 #include <esp_log.h>
 
+#include <bitset>
+#include <stdexcept>
+
+#include "hal/Clock.h"
+#include "hal/Io.h"
+#include "util/EventLog.h"
+#include "util/Metrics.h"
+
 OperationController::OperationController() { io::ServoOutputChannel::initLedc(); }
 
-void OperationController::addNewChannel(const config::ConfigGpio &cfg) {
+OperationController::~OperationController() {
+    if (wakeTimer_ != nullptr) {
+        esp_timer_stop(wakeTimer_);
+        esp_timer_delete(wakeTimer_);
+    }
+}
+
+void OperationController::insertChannel(const config::ConfigGpio &cfg) {
     switch (cfg.type) {
         case config::ChannelType::eDisabled:
         default:
-            gpio_reset_pin(cfg.gpio());
+            hal::gpio().reset(cfg.gpio());
+            updatePosition(cfg.channel, {});
             break;
-        case config::ChannelType::eSmartButton:
-            buttonChannels_.insert({cfg.channel, io::SmartButtonChannel(cfg)});
+        case config::ChannelType::eSmartButton: {
+            updatePosition(cfg.channel, {});
+            config::ConfigGpio resolved = cfg;
+            const std::string &routeName = cfg.buttonCfg_->route;
+            if (!routeName.empty()) {
+                // a route button uses the actions of its route, its LED shows whether the route is set
+                auto route = routeTable_.find(routeName);
+                resolved.buttonCfg_->actionOnPress =
+                    route.has_value() ? routeTable_[*route].actions : std::vector<config::SwitchAction>{};
+            }
+            auto &button = buttonChannels_[cfg.channel].emplace(resolved);
+            const auto &actions = resolved.buttonCfg_->actionOnPress;
+            for (size_t i = 0; i < actions.size(); i++) {
+                if (actions[i].ip.empty()) {
+                    buttonDependencies_[actions[i].channel].push_back({cfg.channel, static_cast<uint16_t>(i)});
+                }
+            }
+            button.updateMatchingState(servoOutChannels_);
+            sampler_.attach(cfg.channel, cfg.buttonCfg_->invertedInput, cfg.buttonCfg_->invertedOutput);
+            sampler_.setMatchingState(cfg.channel, button.getMatchingState());
             break;
+        }
         case config::ChannelType::eServo: {
-            servoOutChannels_.insert({cfg.channel, io::ServoOutputChannel(cfg)});
+            auto &servo = servoOutChannels_[cfg.channel].emplace(cfg, positions_[cfg.channel]);
+            sense_.configure(cfg.channel, *cfg.servoCfg_);
+            servoChanged(cfg.channel);
+            if (servo.getDirection() == config::SwitchDirection::eUnknown) {
+                ESP_LOGI("Controller", "Position of %s is unknown, resynchronizing", config::channelName(cfg.channel));
+                config::SwitchAction resync{};
+                resync.channel = cfg.channel;
+                resync.direction = config::SwitchDirection::eLeft;
+                queueSwitchChange({resync}, 0, controller::Priority::eLocal);
+            }
             break;
         }
     }
 }
 
-void OperationController::updateChannel(const config::ConfigGpio &cfg) {
-    const std::lock_guard<std::mutex> lock(changeMutex_);
-    servoOutChannels_.erase(cfg.channel);
-    buttonChannels_.erase(cfg.channel);
+void OperationController::removeChannel(config::ChannelId channel) {
+    finishMove(channel, std::chrono::steady_clock::time_point::max());
+    dropPendingAction(channel);
+    if (servoOutChannels_[channel].has_value()) {
+        servoOutChannels_[channel].reset();
+        servoChanged(channel);
+    }
+    if (buttonChannels_[channel].has_value()) {
+        sampler_.detach(channel);
+        buttonChannels_[channel].reset();
+        for (auto &deps : buttonDependencies_) {
+            std::erase_if(deps, [channel](const ActionRef &ref) { return ref.button == channel; });
+        }
+    }
+}
+
+void OperationController::sendCommand(controller::Command &&cmd) {
+    if (!commands_.push(std::move(cmd))) {
+        throw std::runtime_error("Controller is busy, please try again.");
+    }
+    wake();
+}
+
+void OperationController::updateChannel(const config::ConfigGpio &cfg) { sendCommand(controller::UpdateChannel{cfg}); }
+
+void OperationController::checkInterlocking(const std::vector<config::SwitchAction> &req) {
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    for (const auto &item : req) {
+        if (item.ip.empty() && lockedServosSnapshot_.test(item.channel)) {
+            throw std::invalid_argument(std::string("Channel ") + config::channelName(item.channel) +
+                                        " belongs to a locked route.");
+        }
+    }
+}
+
+void OperationController::checkTargets(const std::vector<config::SwitchAction> &req) {
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    for (const auto &item : req) {
+        if (!item.ip.empty() || statusSnapshot_[item.channel].servo.has_value()) {
+            return;
+        }
+    }
+    throw std::invalid_argument("None of the actions targets a configured servo.");
+}
+
+void OperationController::forceSwitchChange(const config::SwitchAction &req) {
+    checkInterlocking({req});
+    sendCommand(controller::ForceSwitchChange{req});
+}
+
+controller::RouteId OperationController::requestSwitchChange(const std::vector<config::SwitchAction> &req,
+                                                             controller::Priority priority) {
+    checkInterlocking(req);
+    checkTargets(req);
+    controller::RouteId route = nextRoute_.fetch_add(1);
+    sendCommand(controller::RequestSwitchChange{req, route, priority});
+    return route;
+}
+
+void OperationController::setPowerConfig(const config::PowerConfig &cfg) {
+    sendCommand(controller::SetPowerConfig{cfg});
+}
+
+void OperationController::setRoutes(const config::RouteConfig &cfg) { sendCommand(controller::SetRoutes{cfg}); }
+
+controller::RouteId OperationController::lockRoute(const std::string &name) {
+    controller::RouteId route = nextRoute_.fetch_add(1);
+    sendCommand(controller::LockRoute{name, true, route});
+    return route;
+}
+
+void OperationController::releaseRoute(const std::string &name) {
+    sendCommand(controller::LockRoute{name, false});
+}
 
-    addNewChannel(cfg);
+void OperationController::restorePositions(const config::ServoPositions &positions) {
+    sendCommand(controller::RestorePositions{positions});
 }
 
-void OperationController::forceSwitchChange(config::SwitchAction &req) {
-    const std::lock_guard<std::mutex> lock(changeMutex_);
+void OperationController::handleCommand(controller::Command &cmd) {
+    routesDirty_ = true;
+    if (auto *update = std::get_if<controller::UpdateChannel>(&cmd)) {
+        removeChannel(update->cfg.channel);
+        insertChannel(update->cfg);
+    } else if (auto *force = std::get_if<controller::ForceSwitchChange>(&cmd)) {
+        forceSwitchChangeNow(force->action);
+    } else if (auto *request = std::get_if<controller::RequestSwitchChange>(&cmd)) {
+        beginRoute(request->route);
+        queueSwitchChange(request->actions, request->route, request->priority);
+    } else if (auto *power = std::get_if<controller::SetPowerConfig>(&cmd)) {
+        power_ = power->cfg;
+    } else if (auto *routes = std::get_if<controller::SetRoutes>(&cmd)) {
+        applyRoutes(routes->cfg);
+    } else if (auto *restore = std::get_if<controller::RestorePositions>(&cmd)) {
+        for (size_t ch = 0; ch < config::kChannelCount; ch++) {
+            if (!servoOutChannels_[ch].has_value()) {
+                positions_[ch] = restore->positions[ch];
+            }
+        }
+    } else if (auto *lock = std::get_if<controller::LockRoute>(&cmd)) {
+        if (lock->locked) {
+            beginRoute(lock->route);
+            lockRouteNow(lock->name, lock->route, controller::Priority::eRemote);
+        } else if (auto index = routeTable_.find(lock->name)) {
+            lockedRoutes_.reset(*index);
+        }
+    }
+}
 
-    auto servo = servoOutChannels_.find(req.channel);
-    if (servo == servoOutChannels_.end()) {
-        ESP_LOGI("Controller", "Skipping change request, unknown servo output channel: %s", req.channel.c_str());
+void OperationController::forceSwitchChangeNow(const config::SwitchAction &req) {
+    auto &servo = servoOutChannels_[req.channel];
+    if (!servo.has_value()) {
+        ESP_LOGI("Controller", "Skipping change request, unknown servo output channel: %s",
+                 config::channelName(req.channel));
+        return;
+    }
+    if (lockedServos().test(req.channel)) {
+        ESP_LOGI("Controller", "Skipping forced change, %s belongs to a locked route", config::channelName(req.channel));
         return;
     }
 
-    servo->second.setPendingAction(req);
-    servo->second.executePendingAction();
+    dropPendingAction(req.channel);
+    servo->setPendingAction(req);
+    startMove(req.channel, *servo, hal::Clock::now());
+}
+
+void OperationController::dropPendingAction(config::ChannelId channel) {
+    pending_.take(channel);
+    routes_.releaseMove(pendingRoutes_[channel], false);
+    pendingRoutes_[channel] = 0;
+    pendingPresses_[channel] = 0;
+    statusChanged(channel);
+    routesDirty_ = true;
+}
+
+void OperationController::beginRoute(controller::RouteId route) {
+    if (route != 0) {
+        routes_.begin(route);
+    }
+}
+
+controller::ChannelMask OperationController::lockedServos(std::optional<size_t> except) const {
+    controller::ChannelMask servos;
+    for (size_t i = 0; i < routeTable_.size(); i++) {
+        if (lockedRoutes_.test(i) && i != except) {
+            servos |= routeTable_[i].servos;
+        }
+    }
+    return servos;
 }
 
-void OperationController::requestSwitchChange(const std::vector<config::SwitchAction> &req) {
-    const std::lock_guard<std::mutex> lock(changeMutex_);
+void OperationController::queueSwitchChange(const std::vector<config::SwitchAction> &req, controller::RouteId route,
+                                            controller::Priority priority, std::optional<size_t> owner) {
+    std::map<std::string, std::vector<config::SwitchAction>> remote;
+    const controller::ChannelMask interlocked = lockedServos(owner);
+    const uint32_t group = pending_.newGroup();
+    const auto now = hal::Clock::now();
+    bool local = false;
     for (const auto &item : req) {
         if (!item.ip.empty()) {
-            // TODO: Remote switch change
+            remote[item.ip].push_back(item);
             continue;
         }
 
-        auto servo = servoOutChannels_.find(item.channel);
-        if (servo == servoOutChannels_.end()) {
-            ESP_LOGI("Controller", "Skipping change request, unknown servo output channel: %s", item.channel.c_str());
+        auto &servo = servoOutChannels_[item.channel];
+        if (!servo.has_value()) {
+            ESP_LOGI("Controller", "Skipping change request, unknown servo output channel: %s",
+                     config::channelName(item.channel));
+            continue;
+        }
+        local = true;
+        if (interlocked.test(item.channel)) {
+            ESP_LOGI("Controller", "Skipping change request, %s belongs to a locked route",
+                     config::channelName(item.channel));
+            routes_.reject(route);
             continue;
         }
-        servo->second.removePendingAction();
+        servo->removePendingAction();
+        dropPendingAction(item.channel);
 
-        if (item.direction != config::SwitchDirection::eCustom && servo->second.getDirection() == item.direction) {
-            ESP_LOGI("Controller", "Skipping change request, already in position: %s, %d", item.channel.c_str(),
-                     (int)item.direction);
+        if (item.direction != config::SwitchDirection::eCustom && servo->getDirection() == item.direction) {
+            ESP_LOGI("Controller", "Skipping change request, already in position: %s, %d",
+                     config::channelName(item.channel), (int)item.direction);
+            servoChanged(item.channel);
             continue;
         }
 
-        ESP_LOGI("Controller", "Queuing change request: %s, %d", item.channel.c_str(), (int)item.direction);
-        servo->second.setPendingAction(item);
+        ESP_LOGI("Controller", "Queuing change request: %s, %d", config::channelName(item.channel),
+                 (int)item.direction);
+        servo->setPendingAction(item);
+        pending_.push(item.channel, priority, group, now);
+        util::events().record(util::EventType::eQueued, item.channel,
+                              static_cast<uint16_t>(item.direction) | static_cast<uint16_t>(priority) << 8);
+        pendingRoutes_[item.channel] = route;
+        pendingPresses_[item.channel] = buttonPressedAt_;
+        routes_.addMove(route);
+        servoChanged(item.channel);
+    }
+
+    if (!local && remote.empty()) {
+        // a servo was removed after the request was checked, nothing would ever move
+        ESP_LOGW("Controller", "Rejecting route %lu, no action targets a configured servo",
+                 static_cast<unsigned long>(route));
+        routes_.reject(route);
+    } else if (!local && remoteSender_) {
+        routes_.markForwarded(route);
+    }
+    for (auto &[peer, actions] : remote) {
+        if (remoteSender_) {
+            ESP_LOGI("Controller", "Forwarding %zu changes to %s", actions.size(), peer.c_str());
+            // the peer link retransmits lost datagrams, but can't recover actions which never reached it
+            if (!forward(controller::RemoteActions{peer, std::move(actions)})) {
+                routes_.reject(route);
+            }
+        }
+    }
+}
+
+void OperationController::applyRoutes(const config::RouteConfig &cfg) {
+    controller::RouteTable table(cfg);
+    controller::RouteMask locked;
+    for (size_t i = 0; i < table.size(); i++) {
+        auto previous = routeTable_.find(table[i].name);
+        locked.set(i, previous.has_value() && lockedRoutes_.test(*previous));
     }
+    routeTable_ = std::move(table);
+    lockedRoutes_ = locked;
+
+    for (config::ChannelId ch = 0; ch < config::kChannelCount; ch++) {
+        const auto &button = buttonChannels_[ch];
+        if (button.has_value() && !button->getConfig().buttonCfg_->route.empty()) {
+            config::ConfigGpio buttonCfg = button->getConfig();
+            removeChannel(ch);
+            insertChannel(buttonCfg);
+        }
+    }
+
+    const controller::ChannelMask interlocked = lockedServos();
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    routesSnapshot_ = cfg;
+    lockedSnapshot_ = lockedRoutes_;
+    lockedServosSnapshot_ = interlocked;
+    setSnapshot_.reset();
 }
 
-void OperationController::performAction(io::ServoOutputChannel &pendingChange) {
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> lastChange = now - lastDirChange_;
-    if (lastChange.count() < kWaitDurationBetweenNextDirChange) {
-        ESP_LOGD("Controller", "Pending changes in cooldown, skipping.");
+void OperationController::lockRouteNow(const std::string &name, controller::RouteId route,
+                                       controller::Priority priority) {
+    auto index = routeTable_.find(name);
+    if (!index.has_value() || routeTable_.conflicts(*index, lockedRoutes_)) {
+        ESP_LOGI("Controller", "Rejecting route %s, it is unknown or conflicts with a locked route.", name.c_str());
+        routes_.reject(route);
         return;
     }
-    const std::lock_guard<std::mutex> lock(changeMutex_);
-    lastDirChange_ = now;
+    ESP_LOGI("Controller", "Locking route %s", name.c_str());
+    lockedRoutes_.set(*index);
+    queueSwitchChange(routeTable_[*index].actions, route, priority, index);
+}
+
+void OperationController::scheduleOverdrawRelease(config::ChannelId channel, const io::ServoOutputChannel &servo) {
+    if (servo.isOverdrawing()) {
+        deadlines_.schedule(servo.getOverdrawReleaseTime(), controller::DeadlineType::eOverdrawRelease, channel);
+    }
+}
+
+void OperationController::startMove(config::ChannelId channel, io::ServoOutputChannel &servo,
+                                    std::chrono::steady_clock::time_point now) {
+    finishMove(channel, std::chrono::steady_clock::time_point::max());
+    if (auto entry = pending_.take(channel)) {
+        util::metrics().pendingWait[static_cast<size_t>(entry->priority)].record(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - entry->queuedAt).count());
+    }
 
-    pendingChange.executePendingAction();
+    servo.executePendingAction();
+    util::events().record(util::EventType::eMoveStarted, channel, static_cast<uint16_t>(servo.getDirection()));
+    updatePosition(channel, servo.getPosition());
 
-    // now populate the changes
-    for (auto &item : buttonChannels_) {
-        item.second.updateMatchingState(servoOutChannels_);
+    const config::ConfigServo &cfg = *servo.getConfig().servoCfg_;
+    ActiveMove move{cfg.rail, std::min(cfg.inrushCurrent, power_.budget(cfg.rail)), now + servo.getMoveDuration(),
+                    pendingRoutes_[channel], 0, false};
+    pendingRoutes_[channel] = 0;
+    if (pendingPresses_[channel] != 0) {
+        util::metrics().buttonLatency.record(util::metricsNow() - pendingPresses_[channel]);
+        pendingPresses_[channel] = 0;
     }
+    railUsage_[move.rail] += move.current;
+    activeMoves_[channel] = move;
+    armSense(channel, servo);
 
+    servoChanged(channel);
+    scheduleOverdrawRelease(channel, servo);
+    deadlines_.schedule(move.finishAt, controller::DeadlineType::eMoveFinished, channel);
+    if (servo.isMoving() && !motionStepScheduled_) {
+        deadlines_.schedule(now + io::ServoOutputChannel::kMotionStep, controller::DeadlineType::eMotionStep);
+        motionStepScheduled_ = true;
+    }
 }
 
-void OperationController::performNextServoChange() {
-    for (auto &item : servoOutChannels_) {
-        if (item.second.getPendingAction().has_value()) {
-            performAction(item.second);
-            return;
+void OperationController::stepMotion(const controller::Deadline &deadline) {
+    auto now = hal::Clock::now();
+    bool moving = false;
+    for (config::ChannelId ch = 0; ch < config::kChannelCount; ch++) {
+        auto &servo = servoOutChannels_[ch];
+        if (servo.has_value() && servo->isMoving()) {
+            if (servo->stepMotion(now)) {
+                moving = true;
+            } else {
+                armSense(ch, *servo);
+            }
+            statusChanged(ch);
+        }
+    }
+    motionStepScheduled_ = moving;
+    if (moving) {
+        // keep the cadence of the steps, but don't try to catch up on missed ones
+        deadlines_.schedule(std::max(deadline.at + io::ServoOutputChannel::kMotionStep, now),
+                            controller::DeadlineType::eMotionStep);
+    }
+}
+
+void OperationController::armSense(config::ChannelId channel, const io::ServoOutputChannel &servo) {
+    auto &move = activeMoves_[channel];
+    // during a ramp the current and the position input follow the ramp, they are only watched once it ended
+    if (!move.has_value() || move->sense != 0 || servo.isMoving() || !servo.isOverdrawing() || !servo.hasSense()) {
+        return;
+    }
+    move->sense = sense_.arm(channel, servo.getSenseTarget());
+}
+
+void OperationController::finishMove(config::ChannelId channel, std::chrono::steady_clock::time_point scheduledAt) {
+    auto &move = activeMoves_[channel];
+    // a newer move of the same servo has its own deadline
+    if (!move.has_value() || scheduledAt < move->finishAt) {
+        return;
+    }
+    railUsage_[move->rail] -= move->current;
+    if (move->sense != 0) {
+        sense_.disarm(channel);
+    }
+    // a move cut short by a newer one doesn't complete its route
+    routes_.releaseMove(move->route, move->settled || hal::Clock::now() >= move->finishAt);
+    move.reset();
+    routesDirty_ = true;
+}
+
+void OperationController::settleMove(const io::SenseEvent &event) {
+    auto &move = activeMoves_[event.channel];
+    auto &servo = servoOutChannels_[event.channel];
+    // the event may belong to a move which was already replaced
+    if (!move.has_value() || move->sense != event.generation || !servo.has_value()) {
+        return;
+    }
+    servo->settle(event.reason);
+    servoChanged(event.channel);
+    // the sense input replaces the estimated duration of the move, its current is free for pending moves
+    move->settled = true;
+    finishMove(event.channel, std::chrono::steady_clock::time_point::max());
+}
+
+void OperationController::startPendingMoves(std::chrono::steady_clock::time_point now) {
+    std::array<config::ChannelId, config::kChannelCount> order{};
+    size_t count = pending_.order(now, order);
+    // once an action doesn't fit, the later ones on its rail wait as well so they can't take the budget it waits for
+    std::bitset<config::kMaxPowerRails> blocked;
+    for (size_t i = 0; i < count; i++) {
+        config::ChannelId ch = order[i];
+        auto &servo = servoOutChannels_[ch];
+        if (!servo.has_value() || !servo->getPendingAction().has_value() || activeMoves_[ch].has_value()) {
+            continue;
+        }
+        const config::ConfigServo &cfg = *servo->getConfig().servoCfg_;
+        if (blocked.test(cfg.rail)) {
+            continue;
+        }
+        // a single servo exceeding the budget of its rail still moves as soon as the rail is idle
+        int budget = power_.budget(cfg.rail);
+        if (railUsage_[cfg.rail] + std::min(cfg.inrushCurrent, budget) > budget) {
+            ESP_LOGD("Controller", "Power rail %d busy, keeping change of %s pending.", cfg.rail,
+                     config::channelName(ch));
+            blocked.set(cfg.rail);
+            continue;
+        }
+        startMove(ch, *servo, now);
+    }
+}
+
+void OperationController::servoChanged(config::ChannelId channel) {
+    const auto &servo = servoOutChannels_[channel];
+    auto direction = servo.has_value() ? servo->getDirection() : config::SwitchDirection::eUnknown;
+    leftServos_.set(channel, direction == config::SwitchDirection::eLeft);
+    rightServos_.set(channel, direction == config::SwitchDirection::eRight);
+    statusChanged(channel);
+
+    for (const ActionRef &ref : buttonDependencies_[channel]) {
+        auto &button = buttonChannels_[ref.button];
+        if (button->updateAction(ref.slot, servoOutChannels_[channel])) {
+            sampler_.setMatchingState(ref.button, button->getMatchingState());
+        }
+    }
+}
+
+void OperationController::handleDeadline(const controller::Deadline &deadline) {
+    switch (deadline.type) {
+        case controller::DeadlineType::eOverdrawRelease: {
+            auto &servo = servoOutChannels_[deadline.channel];
+            if (servo.has_value()) {
+                servo->checkOverdraw();
+                statusChanged(deadline.channel);
+            }
+            break;
         }
+        case controller::DeadlineType::eMoveFinished:
+            finishMove(deadline.channel, deadline.at);
+            break;
+        case controller::DeadlineType::eMotionStep:
+            stepMotion(deadline);
+            break;
+        case controller::DeadlineType::eStatusRetry:
+            // the dropped channels are still dirty, the snapshot at the end of this tick pushes them again
+            statusRetryScheduled_ = false;
+            break;
+        default:
+            break;
     }
 }
 
 void OperationController::tick() {
-    for (auto &item : buttonChannels_) {
-        if (item.second.tickButton()) {
-            ESP_LOGI("Controller", "Button %s has been pressed, performing change.", item.first.c_str());
-            requestSwitchChange(item.second.getAction());
+    const util::Stopwatch stopwatch(util::metrics().controlTick);
+    util::metrics().commandQueueDepth.record(static_cast<int64_t>(commands_.size()));
+    util::metrics().pendingDepth.record(static_cast<int64_t>(pending_.size()));
+    controller::Command cmd;
+    while (commands_.pop(cmd)) {
+        handleCommand(cmd);
+    }
+
+    io::ButtonEvent event;
+    while (sampler_.popEvent(event)) {
+        auto &button = buttonChannels_[event.channel];
+        if (button.has_value()) {
+            ESP_LOGI("Controller", "Button %s has been pressed, performing change.", config::channelName(event.channel));
+            util::events().record(util::EventType::eButtonPress, event.channel);
+            const std::string &routeName = button->getConfig().buttonCfg_->route;
+            auto route = routeTable_.find(routeName);
+            buttonPressedAt_ = event.pressedAt;
+            routesDirty_ = true;
+            if (routeName.empty()) {
+                queueSwitchChange(button->getAction(), 0, controller::Priority::eManual);
+            } else if (route.has_value() && lockedRoutes_.test(*route)) {
+                // a second press releases the route
+                ESP_LOGI("Controller", "Releasing route %s", routeName.c_str());
+                lockedRoutes_.reset(*route);
+            } else {
+                lockRouteNow(routeName, 0, controller::Priority::eManual);
+            }
+            buttonPressedAt_ = 0;
+        }
+    }
+
+    io::SenseEvent sensed;
+    while (sense_.popEvent(sensed)) {
+        settleMove(sensed);
+    }
+
+    auto now = hal::Clock::now();
+    while (auto deadline = deadlines_.popDue(now)) {
+        util::metrics().deadlineLateness.record(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - deadline->at).count());
+        handleDeadline(*deadline);
+    }
+
+    startPendingMoves(now);
+    publishSnapshot(now);
+}
+
+void OperationController::publishSnapshot(std::chrono::steady_clock::time_point now) {
+    if (dirtyChannels_.none() && !routesDirty_) {
+        return;
+    }
+
+    for (config::ChannelId ch = 0; ch < config::kChannelCount; ch++) {
+        if (!dirtyChannels_.test(ch)) {
+            continue;
+        }
+        const auto &servo = servoOutChannels_[ch];
+        controller::ChannelStatus &status = status_[ch];
+        status.servo = servo.has_value() ? std::optional(servo->getStatus()) : std::nullopt;
+        const auto &entry = pending_.find(ch);
+        status.priority = entry.has_value() ? std::optional(entry->priority) : std::nullopt;
+    }
+
+    controller::RouteMask set;
+    for (size_t i = 0; i < routeTable_.size(); i++) {
+        set.set(i, routeTable_.isSet(i, leftServos_, rightServos_));
+    }
+    const controller::ChannelMask interlocked = lockedServos();
+
+    {
+        // only plain values are copied, readers build their json outside of the lock
+        const std::lock_guard<std::mutex> lock(snapshotMutex_);
+        statusSnapshot_ = status_;
+        lockedSnapshot_ = lockedRoutes_;
+        lockedServosSnapshot_ = interlocked;
+        setSnapshot_ = set;
+        powerSnapshot_ = power_;
+        routeSnapshot_ = routes_;
+    }
+
+    controller::ChannelMask dropped;
+    if (statusListener_) {
+        for (config::ChannelId ch = 0; ch < config::kChannelCount; ch++) {
+            const controller::ChannelStatus &status = status_[ch];
+            // intermediate positions of a ramp are not pushed, only its result
+            if (status == pushed_[ch] || (status.servo.has_value() && status.servo->moving)) {
+                continue;
+            }
+            if (notify(controller::StatusDelta{ch, status})) {
+                pushed_[ch] = status;
+            } else {
+                dropped.set(ch);
+            }
         }
     }
+    // a delta dropped by a full queue stays dirty and is retried once the notifier had time to drain the queue
+    dirtyChannels_ = dropped;
+    routesDirty_ = false;
+    if (dropped.any() && !statusRetryScheduled_) {
+        deadlines_.schedule(now + kStatusRetryDelay, controller::DeadlineType::eStatusRetry);
+        statusRetryScheduled_ = true;
+    }
+}
+
+void OperationController::updatePosition(config::ChannelId channel, config::ServoPosition position) {
+    config::ServoPosition &current = positions_[channel];
+    if (current.direction == position.direction && current.time == position.time) {
+        return;
+    }
+    current = position;
+    if (positionListener_) {
+        notify(controller::PositionChange{positions_});
+    }
+}
+
+bool OperationController::notify(controller::Notification &&notification) {
+    if (!notifications_.push(std::move(notification))) {
+        ESP_LOGW("Controller", "Notification queue full, dropping notification");
+        return false;
+    }
+    wakeNotifier();
+    return true;
+}
+
+bool OperationController::forward(controller::RemoteActions &&actions) {
+    if (!remoteActions_.push(std::move(actions))) {
+        ESP_LOGW("Controller", "Remote queue full, unable to forward changes");
+        return false;
+    }
+    wakeNotifier();
+    return true;
+}
+
+void OperationController::wakeNotifier() {
+    TaskHandle_t notifier = notifier_.load();
+    if (notifier != nullptr) {
+        xTaskNotifyGive(notifier);
+    }
+}
+
+void OperationController::dispatchNotifications() {
+    controller::Notification notification;
+    // the changes of a tick are passed to the status listener at once
+    nlohmann::json delta = nlohmann::json::array();
+    while (notifications_.pop(notification)) {
+        if (auto *changed = std::get_if<controller::StatusDelta>(&notification)) {
+            if (changed->status.servo.has_value()) {
+                delta.push_back(changed->status);
+            } else {
+                delta.push_back({{"channel", config::channelName(changed->channel)}, {"removed", true}});
+            }
+        } else if (auto *change = std::get_if<controller::PositionChange>(&notification)) {
+            positionListener_(change->positions);
+        }
+    }
+    if (!delta.empty()) {
+        statusListener_(delta);
+    }
+
+    controller::RemoteActions remote;
+    while (remoteActions_.pop(remote)) {
+        remoteSender_(remote.peer, remote.actions);
+    }
+}
+
+void OperationController::runNotifier() {
+    notifier_ = xTaskGetCurrentTaskHandle();
+    while (true) {
+        dispatchNotifications();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void OperationController::wake() {
+    TaskHandle_t task = task_.load();
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void OperationController::wakeTimerCallback(void *arg) { static_cast<OperationController *>(arg)->wake(); }
+
+void OperationController::armWakeTimer() {
+    std::optional<std::chrono::steady_clock::time_point> next = deadlines_.next();
+    esp_timer_stop(wakeTimer_);
+    if (!next.has_value()) {
+        return;
+    }
+    auto delay = std::chrono::duration_cast<std::chrono::microseconds>(*next - hal::Clock::now());
+    esp_timer_start_once(wakeTimer_, std::max<int64_t>(delay.count(), 0));
+}
 
-    performNextServoChange();
+void OperationController::run() {
+    esp_timer_create_args_t args{};
+    args.callback = &OperationController::wakeTimerCallback;
+    args.arg = this;
+    args.name = "ctrl_wake";
+    esp_timer_create(&args, &wakeTimer_);
 
-    for (auto &item : servoOutChannels_) {
-        item.second.checkOverdraw();
+    task_ = xTaskGetCurrentTaskHandle();
+    sampler_.setConsumer(task_);
+    sampler_.start();
+    sense_.setConsumer(task_);
+    sense_.start();
+    while (true) {
+        tick();
+        armWakeTimer();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
+config::PowerConfig OperationController::getPowerConfig() {
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return powerSnapshot_;
+}
+
 nlohmann::json OperationController::generateStatus() {
-    const std::lock_guard<std::mutex> lock(changeMutex_);
-    nlohmann::json arr = nlohmann::json::array();
-    for (const auto &item : servoOutChannels_) {
-        arr.push_back(item.second);
+    controller::StatusTable status;
+    {
+        const std::lock_guard<std::mutex> lock(snapshotMutex_);
+        status = statusSnapshot_;
+    }
+    return controller::statusToJson(status);
+}
+
+std::optional<controller::RouteStatus> OperationController::getRouteStatus(controller::RouteId id) {
+    if (id == 0 || id >= nextRoute_.load()) {
+        return std::nullopt;
+    }
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return routeSnapshot_.find(id);
+}
+
+config::RouteConfig OperationController::getRoutes() {
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return routesSnapshot_;
+}
+
+nlohmann::json OperationController::generateRouteStatus() {
+    const std::lock_guard<std::mutex> lock(snapshotMutex_);
+    nlohmann::json j = nlohmann::json::array();
+    for (size_t i = 0; i < routesSnapshot_.routes.size(); i++) {
+        j.push_back({{"name", routesSnapshot_.routes[i].name},
+                     {"locked", lockedSnapshot_.test(i)},
+                     {"set", setSnapshot_.test(i)}});
     }
-    return arr;
+    return j;
 }
@@ -21,73 +21,376 @@
 #ifndef SWITCHCONTROL_CONTROLLER_OPERATIONCONTROLLER_H
 #define SWITCHCONTROL_CONTROLLER_OPERATIONCONTROLLER_H
 
-#include <queue>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <vector>
 
-#include "config/ConfigurationStorage.h"
+#include "ChannelStatus.h"
+#include "Command.h"
+#include "DeadlineQueue.h"
+#include "PendingQueue.h"
+#include "RouteTable.h"
+#include "RouteTracker.h"
+#include "config/GpioConfig.h"
+#include "config/PowerConfig.h"
+#include "config/RouteConfig.h"
 #include "config/ServoConfig.h"
+#include "io/ButtonSampler.h"
+#include "io/SenseSampler.h"
 #include "io/ServoOutChannel.h"
 #include "io/SmartButtonChannel.h"
+#include "util/MpscQueue.h"
+#include "util/SpscQueue.h"
 
 /**
  * @brief This class is the controller to manage changing servo states.
- * It polls every registered buttons and set new values to the available servos.
+ * It handles the presses reported by the button sampler and set new values to the available servos.
+ * The controller only wakes up for button presses, new requests and its own deadlines.
+ * Servos move in parallel as long as the current budget of their power rail allows it, all other requests stay
+ * pending until enough moves on that rail are finished. Pending requests start by priority class, button presses
+ * before local automation before remote and http requests, and in request order within a class.
+ *
+ * All channel state is owned by the control loop. Other tasks send commands through a lock-free queue and read the
+ * status from a snapshot the loop publishes after each tick in which something changed. The snapshot only holds plain
+ * values, json is built by the reader. Status changes and actions for other boards leave the loop through a second
+ * queue, which is drained by a notifier task on the network core.
  */
 class OperationController {
    public:
-    const inline static double kWaitDurationBetweenNextDirChange = 1;
+    // the control loop and the button sampling run on the APP_CPU, network and storage on the PRO_CPU
+    const inline static int kTaskPriority = 9;
+    const inline static BaseType_t kTaskCore = 1;
+    const inline static int kNotifierPriority = 5;
+    const inline static BaseType_t kNetworkCore = 0;
 
     /**
      * @brief Create a new controller.
      */
     OperationController();
-    ~OperationController() = default;
+    ~OperationController();
 
     /**
-     * @brief Add a new channel for a GPIO to the controller.
-     * @param cfg the configuration of the gpio
-     */
-    void addNewChannel(const config::ConfigGpio &cfg);
-    /**
-     * @brief Update an existing configuration of a GPIO.
+     * @brief Add a new channel or update an existing configuration of a GPIO.
      * @param cfg the configuration of the gpio
+     * @throws std::runtime_error if the command queue is full
      */
     void updateChannel(const config::ConfigGpio &cfg);
 
     /**
      * @brief Request multiple switch change.
      * This will queue the switch change to prevent multiple changes at the same time.
+     * All changes are handled by the control loop at once, the returned route tracks their completion.
      * @param req list of requested changes
+     * @param priority the priority class of the changes, pending changes of a higher class start first
+     * @return the id of the route
+     * @throws std::invalid_argument if a servo belongs to a locked route or no action targets a servo at all
+     * @throws std::runtime_error if the command queue is full
      */
-    void requestSwitchChange(const std::vector<config::SwitchAction> &req);
+    controller::RouteId requestSwitchChange(const std::vector<config::SwitchAction> &req,
+                                            controller::Priority priority = controller::Priority::eRemote);
     /**
      * @brief Force a switch change now.
-     * Request a change now. This bypasses the queue.
+     * Request a change now. This bypasses the queue, but not the interlocking of locked routes.
      * @param req the action
+     * @throws std::invalid_argument if the servo belongs to a locked route
+     * @throws std::runtime_error if the command queue is full
+     */
+    void forceSwitchChange(const config::SwitchAction &req);
+
+    /**
+     * @brief Set the current budgets of the power rails.
+     * @param cfg the power configuration
+     * @throws std::runtime_error if the command queue is full
+     */
+    void setPowerConfig(const config::PowerConfig &cfg);
+    [[nodiscard]] config::PowerConfig getPowerConfig();
+
+    /**
+     * @brief Replace all named routes. Locks of routes which still exist are kept.
+     * @param cfg the routes
+     * @throws std::runtime_error if the command queue is full
+     */
+    void setRoutes(const config::RouteConfig &cfg);
+    [[nodiscard]] config::RouteConfig getRoutes();
+
+    /**
+     * @brief Set the positions servos start in when their channel is added, positions of existing servos are kept.
+     * A servo with a known position starts without moving, all others are moved to the left through the power budget
+     * like any other request, so they don't start at the same time.
+     * @param positions the positions saved before the restart
+     * @throws std::runtime_error if the command queue is full
+     */
+    void restorePositions(const config::ServoPositions &positions);
+
+    /**
+     * @brief Lock a named route and move its servos.
+     * The route is rejected if it shares a servo with another locked route.
+     * @param name the name of the route
+     * @return the id tracking the completion of the route
+     * @throws std::runtime_error if the command queue is full
+     */
+    controller::RouteId lockRoute(const std::string &name);
+    /**
+     * @brief Release the lock of a named route, the servos keep their position.
+     * @param name the name of the route
+     * @throws std::runtime_error if the command queue is full
+     */
+    void releaseRoute(const std::string &name);
+
+    /**
+     * @brief Get the lock state of all named routes and whether all their servos are in position.
+     * @return a json array containing the state of each route
      */
-    void forceSwitchChange(config::SwitchAction &req);
+    nlohmann::json generateRouteStatus();
 
     /**
-     * @brief Create a status of all channels and the controller.
+     * @brief Get the status of all channels as published after the last tick.
      * @return a json object containing the status
      */
     nlohmann::json generateStatus();
 
     /**
-     * @brief Tick the controller. Should be ticked every 20ms.
+     * @brief Get the completion of a route as published after the last tick.
+     * @param id the route returned by requestSwitchChange
+     * @return the status or nothing if the route is unknown or too old
+     */
+    [[nodiscard]] std::optional<controller::RouteStatus> getRouteStatus(controller::RouteId id);
+
+    /**
+     * @brief Set a listener receiving the states of all channels which changed during a tick.
+     * The listener is called from the notifier task. Has to be set before run() is called.
+     * @param listener the listener
+     */
+    void setStatusListener(std::function<void(const nlohmann::json &)> listener) {
+        statusListener_ = std::move(listener);
+    }
+
+    /**
+     * @brief Set the sender forwarding actions for other boards. All actions of a request bound for the same peer are
+     * passed at once. The sender is called from the notifier task. Has to be set before run() is called.
+     * @param sender the sender, receives the address of the peer and its actions
+     */
+    void setRemoteSender(std::function<void(const std::string &, const std::vector<config::SwitchAction> &)> sender) {
+        remoteSender_ = std::move(sender);
+    }
+
+    /**
+     * @brief Set a listener receiving the commanded positions of all servos whenever one of them changes.
+     * The listener is called from the notifier task. Has to be set before run() is called.
+     * @param listener the listener
+     */
+    void setPositionListener(std::function<void(const config::ServoPositions &)> listener) {
+        positionListener_ = std::move(listener);
+    }
+
+    /**
+     * @brief Tick the controller. Handles commands, button presses, all due deadlines and pending changes.
+     * Must only be called from the control loop.
      */
     void tick();
 
+    /**
+     * @brief Run the controller in the calling task. Starts sampling the buttons and sleeps until the next button
+     * press, request or deadline.
+     */
+    [[noreturn]] void run();
+
+    /**
+     * @brief Pass all notifications of the control loop to the status listener and the remote sender.
+     * Must only be called from a single task.
+     */
+    void dispatchNotifications();
+
+    /**
+     * @brief Deliver the notifications of the control loop in the calling task, it sleeps until the loop sends some.
+     */
+    [[noreturn]] void runNotifier();
+
+    /**
+     * @brief Sample all buttons once in the calling task. Used by simulations which tick the controller themselves
+     * instead of calling run().
+     */
+    void sampleButtons() { sampler_.samplePass(); }
+    /**
+     * @brief Sample the sense inputs once in the calling task, see sampleButtons().
+     */
+    void sampleSense() { sense_.samplePass(); }
+
    private:
-    std::mutex changeMutex_;
+    static constexpr size_t kCommandQueueSize = 32;
+    // a status change of every channel and a few other notifications fit into a single tick
+    static constexpr size_t kNotificationQueueSize = 64;
+    static constexpr size_t kRemoteQueueSize = 16;
+    static constexpr std::chrono::milliseconds kStatusRetryDelay{50};
+
+    std::atomic<TaskHandle_t> task_{nullptr};
+    util::MpscQueue<controller::Command, kCommandQueueSize> commands_;
+    std::atomic<controller::RouteId> nextRoute_{1};
+
+    // written by the control loop, read by other tasks
+    std::mutex snapshotMutex_;
+    controller::StatusTable statusSnapshot_{};
+    config::PowerConfig powerSnapshot_{};
+    controller::RouteTracker routeSnapshot_;
+    config::RouteConfig routesSnapshot_{};
+    controller::RouteMask lockedSnapshot_{};
+    controller::ChannelMask lockedServosSnapshot_{};
+    controller::RouteMask setSnapshot_{};
+
+    util::SpscQueue<controller::Notification, kNotificationQueueSize> notifications_;
+    util::SpscQueue<controller::RemoteActions, kRemoteQueueSize> remoteActions_;
+    std::atomic<TaskHandle_t> notifier_{nullptr};
+    std::function<void(const nlohmann::json &)> statusListener_;
+    std::function<void(const std::string &, const std::vector<config::SwitchAction> &)> remoteSender_;
+    std::function<void(const config::ServoPositions &)> positionListener_;
+    esp_timer_handle_t wakeTimer_{nullptr};
+
+    struct ActiveMove {
+        int rail;
+        int current;
+        std::chrono::steady_clock::time_point finishAt;
+        controller::RouteId route;
+        uint32_t sense;  ///< arming of the sense input, 0 without one
+        bool settled;    ///< the sense input reported the servo in position
+    };
+
+    controller::DeadlineQueue deadlines_;
+    config::PowerConfig power_{};
+    std::array<int, config::kMaxPowerRails> railUsage_{};
+    std::array<std::optional<ActiveMove>, config::kChannelCount> activeMoves_{};
+    bool motionStepScheduled_{false};
+
+    controller::RouteTracker routes_;
+    controller::PendingQueue pending_;
+    // route of the pending action of each servo
+    std::array<controller::RouteId, config::kChannelCount> pendingRoutes_{};
+    // metrics timestamp of the button press behind the pending action of each servo
+    std::array<int64_t, config::kChannelCount> pendingPresses_{};
+    int64_t buttonPressedAt_{0};
+
+    // status of all channels and the channels which changed since the last snapshot
+    controller::StatusTable status_{};
+    controller::ChannelMask dirtyChannels_{};
+    // the routes, their locks or the power config changed since the last snapshot
+    bool routesDirty_{false};
+    // status last passed to the notifier, ramps are only pushed once they ended
+    controller::StatusTable pushed_{};
+    // a dropped status delta is retried by the next tick, this deadline wakes the loop for it
+    bool statusRetryScheduled_{false};
 
-    std::chrono::steady_clock::time_point lastDirChange_{std::chrono::steady_clock::now()};
+    controller::RouteTable routeTable_;
+    controller::RouteMask lockedRoutes_{};
+    // current position of all servos, kept for the route masks
+    controller::ChannelMask leftServos_{};
+    controller::ChannelMask rightServos_{};
+    // commanded position of all servos, restored when a servo is added
+    config::ServoPositions positions_{};
 
-    std::map<std::string, io::SmartButtonChannel> buttonChannels_;
-    std::map<std::string, io::ServoOutputChannel> servoOutChannels_;
+    io::ButtonChannelTable buttonChannels_{};
+    io::ServoChannelTable servoOutChannels_{};
+
+    /**
+     * @brief Reference to a single action of a smart button.
+     */
+    struct ActionRef {
+        config::ChannelId button;
+        uint16_t slot;
+    };
+    // buttons and their actions referencing a servo, indexed by the servo channel
+    std::array<std::vector<ActionRef>, config::kChannelCount> buttonDependencies_{};
+
+    io::ButtonSampler sampler_;
+    io::SenseSampler sense_;
+
+    void sendCommand(controller::Command &&cmd);
+    /**
+     * @brief Reject actions for servos of a locked route before they are queued, using the published snapshot.
+     * The control loop checks again, since a route may get locked in the meantime.
+     * @throws std::invalid_argument if a servo belongs to a locked route
+     */
+    void checkInterlocking(const std::vector<config::SwitchAction> &req);
+    /**
+     * @brief Reject a request which neither targets a configured servo nor another board, it would never move.
+     * @throws std::invalid_argument if no action has a target
+     */
+    void checkTargets(const std::vector<config::SwitchAction> &req);
+    /**
+     * @brief Pass a notification to the notifier task.
+     * @return false if the queue is full and the notification was dropped
+     */
+    bool notify(controller::Notification &&notification);
+    /**
+     * @brief Pass actions for another board to the notifier task.
+     * @return false if the queue is full and the actions were not sent
+     */
+    bool forward(controller::RemoteActions &&actions);
+    void wakeNotifier();
+    void handleCommand(controller::Command &cmd);
+    void publishSnapshot(std::chrono::steady_clock::time_point now);
+
+    void insertChannel(const config::ConfigGpio &cfg);
+    void removeChannel(config::ChannelId channel);
+    void beginRoute(controller::RouteId route);
+    /**
+     * @brief Queue changes of local servos and forward the remote ones.
+     * Changes of servos owned by a locked route are skipped and reject the route.
+     * @param owner the locked route the changes belong to, its servos are not interlocked
+     */
+    void queueSwitchChange(const std::vector<config::SwitchAction> &req, controller::RouteId route,
+                           controller::Priority priority, std::optional<size_t> owner = std::nullopt);
+    /**
+     * @brief Servos of all locked routes except one.
+     */
+    [[nodiscard]] controller::ChannelMask lockedServos(std::optional<size_t> except = std::nullopt) const;
+    void applyRoutes(const config::RouteConfig &cfg);
+    void lockRouteNow(const std::string &name, controller::RouteId route, controller::Priority priority);
+    /**
+     * @brief Drop the queue entry and the route of a pending action which gets replaced or removed.
+     */
+    void dropPendingAction(config::ChannelId channel);
+    void forceSwitchChangeNow(const config::SwitchAction &req);
+    void scheduleOverdrawRelease(config::ChannelId channel, const io::ServoOutputChannel &servo);
+    /**
+     * @brief Start watching the sense input of an overdrawing servo once its ramp ended.
+     */
+    void armSense(config::ChannelId channel, const io::ServoOutputChannel &servo);
+    void handleDeadline(const controller::Deadline &deadline);
+    void startPendingMoves(std::chrono::steady_clock::time_point now);
+    void startMove(config::ChannelId channel, io::ServoOutputChannel &servo, std::chrono::steady_clock::time_point now);
+    void finishMove(config::ChannelId channel, std::chrono::steady_clock::time_point scheduledAt);
+    /**
+     * @brief End the overdraw and the move of a servo reported in position by its sense input.
+     */
+    void settleMove(const io::SenseEvent &event);
+    /**
+     * @brief Advance the ramps of all moving servos in a single pass.
+     */
+    void stepMotion(const controller::Deadline &deadline);
+    /**
+     * @brief Update the LEDs of all buttons with an action for a servo after the state of the servo changed.
+     */
+    void servoChanged(config::ChannelId channel);
+    /**
+     * @brief Mark the status of a channel for the next snapshot.
+     */
+    void statusChanged(config::ChannelId channel) { dirtyChannels_.set(channel); }
+    /**
+     * @brief Remember the commanded position of a servo and pass the positions to the position listener.
+     */
+    void updatePosition(config::ChannelId channel, config::ServoPosition position);
 
-    void performNextServoChange();
-    void performAction(io::ServoOutputChannel &pendingChange);
+    void wake();
+    void armWakeTimer();
+    static void wakeTimerCallback(void *arg);
 };
 
 #endif  // SWITCHCONTROL_CONTROLLER_OPERATIONCONTROLLER_H
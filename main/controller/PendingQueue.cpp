@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PendingQueue.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace controller {
+
+void PendingQueue::push(config::ChannelId channel, Priority priority, uint32_t group,
+                        std::chrono::steady_clock::time_point now) {
+    if (!entries_[channel].has_value()) {
+        size_++;
+    }
+    entries_[channel] = Entry{priority, group, now};
+}
+
+std::optional<PendingQueue::Entry> PendingQueue::take(config::ChannelId channel) {
+    std::optional<Entry> entry = entries_[channel];
+    if (entry.has_value()) {
+        entries_[channel].reset();
+        size_--;
+    }
+    return entry;
+}
+
+int PendingQueue::effectivePriority(const Entry &entry, std::chrono::steady_clock::time_point now) const {
+    auto priority = static_cast<int>(entry.priority);
+    if (entry.priority == Priority::eManual) {
+        return priority;
+    }
+    auto promotions = static_cast<int>((now - entry.queuedAt) / kAgingStep);
+    return std::max(priority - promotions, static_cast<int>(Priority::eLocal));
+}
+
+size_t PendingQueue::order(std::chrono::steady_clock::time_point now,
+                           std::array<config::ChannelId, config::kChannelCount> &order) const {
+    size_t count = 0;
+    for (config::ChannelId ch = 0; ch < config::kChannelCount; ch++) {
+        if (entries_[ch].has_value()) {
+            order[count++] = ch;
+        }
+    }
+    // groups are numbered in request order, the channel only keeps the order within a request stable
+    std::sort(order.begin(), order.begin() + count, [&](config::ChannelId a, config::ChannelId b) {
+        const Entry &lhs = *entries_[a];
+        const Entry &rhs = *entries_[b];
+        return std::make_tuple(effectivePriority(lhs, now), lhs.group, a) <
+               std::make_tuple(effectivePriority(rhs, now), rhs.group, b);
+    });
+    return count;
+}
+}  // namespace controller
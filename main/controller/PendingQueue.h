@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_PENDINGQUEUE_H
+#define SWITCHCONTROL_CONTROLLER_PENDINGQUEUE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "config/ChannelRegistry.h"
+#include "util/Priority.h"
+
+namespace controller {
+using util::kPriorityCount;
+using util::Priority;
+using util::priorityName;
+
+/**
+ * @brief Start order of the pending servo actions. Each servo has at most one pending action.
+ * Actions are ordered by their priority class, within a class by the request they belong to and all actions of a
+ * request stay together. Waiting actions are promoted by one class per kAgingStep so no request starves, but never
+ * to eManual: a button press always goes ahead of the requests already waiting.
+ */
+class PendingQueue {
+   public:
+    static constexpr std::chrono::milliseconds kAgingStep{1000};
+
+    struct Entry {
+        Priority priority;
+        uint32_t group;  ///< the request the action belongs to, older requests have lower values
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    /**
+     * @brief Start a new group, all actions of a request are pushed with the same group.
+     */
+    uint32_t newGroup() { return nextGroup_++; }
+
+    /**
+     * @brief Queue the action of a servo, an action already queued for the servo is replaced.
+     */
+    void push(config::ChannelId channel, Priority priority, uint32_t group, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Remove the action of a servo.
+     * @return the removed entry or nothing if no action was queued
+     */
+    std::optional<Entry> take(config::ChannelId channel);
+
+    [[nodiscard]] const std::optional<Entry> &find(config::ChannelId channel) const { return entries_[channel]; }
+    [[nodiscard]] size_t size() const { return size_; }
+
+    /**
+     * @brief Get the queued servos in the order they should start.
+     * @param now the current time, used for aging
+     * @param order receives the channels
+     * @return the number of channels written to order
+     */
+    size_t order(std::chrono::steady_clock::time_point now,
+                 std::array<config::ChannelId, config::kChannelCount> &order) const;
+
+   private:
+    std::array<std::optional<Entry>, config::kChannelCount> entries_{};
+    size_t size_{0};
+    uint32_t nextGroup_{0};
+
+    [[nodiscard]] int effectivePriority(const Entry &entry, std::chrono::steady_clock::time_point now) const;
+};
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_PENDINGQUEUE_H
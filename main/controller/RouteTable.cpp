@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RouteTable.h"
+
+namespace controller {
+
+RouteTable::RouteTable(const config::RouteConfig &cfg) {
+    routes_.reserve(cfg.routes.size());
+    for (const auto &route : cfg.routes) {
+        CompiledRoute &compiled = routes_.emplace_back();
+        compiled.name = route.name;
+        compiled.actions = route.actions;
+        for (const auto &action : route.actions) {
+            if (!action.ip.empty()) {
+                continue;
+            }
+            compiled.servos.set(action.channel);
+            if (action.direction == config::SwitchDirection::eLeft ||
+                action.direction == config::SwitchDirection::eRight) {
+                compiled.positioned.set(action.channel);
+                compiled.right.set(action.channel, action.direction == config::SwitchDirection::eRight);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < routes_.size(); i++) {
+        for (size_t j = i + 1; j < routes_.size(); j++) {
+            if ((routes_[i].servos & routes_[j].servos).any()) {
+                routes_[i].conflicts.set(j);
+                routes_[j].conflicts.set(i);
+            }
+        }
+    }
+}
+
+std::optional<size_t> RouteTable::find(std::string_view name) const {
+    for (size_t i = 0; i < routes_.size(); i++) {
+        if (routes_[i].name == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+}  // namespace controller
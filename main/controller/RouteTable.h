@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_ROUTETABLE_H
+#define SWITCHCONTROL_CONTROLLER_ROUTETABLE_H
+
+#include <bitset>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config/RouteConfig.h"
+
+namespace controller {
+using ChannelMask = std::bitset<config::kChannelCount>;
+using RouteMask = std::bitset<config::kMaxRoutes>;
+
+/**
+ * @brief A route resolved into masks of the servo channels it uses.
+ */
+struct CompiledRoute {
+    std::string name;
+    std::vector<config::SwitchAction> actions;
+    ChannelMask servos;      ///< local servos changed by the route
+    ChannelMask positioned;  ///< local servos moved to the left or right position
+    ChannelMask right;       ///< positioned servos moved to the right
+    RouteMask conflicts;     ///< other routes sharing at least one servo with this route
+};
+
+/**
+ * @brief All routes, compiled once when the configuration changes.
+ * Checking whether a route conflicts with the locked routes or is set is a single mask operation.
+ */
+class RouteTable {
+   public:
+    RouteTable() = default;
+    explicit RouteTable(const config::RouteConfig &cfg);
+
+    [[nodiscard]] std::optional<size_t> find(std::string_view name) const;
+    [[nodiscard]] size_t size() const { return routes_.size(); }
+    [[nodiscard]] const CompiledRoute &operator[](size_t route) const { return routes_[route]; }
+
+    /**
+     * @brief Check whether a route shares a servo with any of the locked routes.
+     */
+    [[nodiscard]] bool conflicts(size_t route, const RouteMask &locked) const {
+        return (routes_[route].conflicts & locked).any();
+    }
+
+    /**
+     * @brief Check whether all servos of a route are in the position of the route.
+     * @param route the route
+     * @param left servos in the left position
+     * @param right servos in the right position
+     */
+    [[nodiscard]] bool isSet(size_t route, const ChannelMask &left, const ChannelMask &right) const {
+        const CompiledRoute &r = routes_[route];
+        return (left & r.positioned) == (r.positioned & ~r.right) && (right & r.positioned) == r.right;
+    }
+
+   private:
+    std::vector<CompiledRoute> routes_;
+};
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_ROUTETABLE_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RouteTracker.h"
+
+namespace controller {
+
+RouteState RouteStatus::state() const {
+    if (rejected) {
+        return RouteState::eRejected;
+    }
+    if (queued || remaining > 0) {
+        return RouteState::ePending;
+    }
+    if (superseded) {
+        return RouteState::eSuperseded;
+    }
+    return forwarded ? RouteState::eForwarded : RouteState::eDone;
+}
+
+void to_json(nlohmann::json &j, const RouteStatus &status) {
+    j["route"] = status.id;
+    j["state"] = status.state();
+    j["remaining"] = status.remaining;
+}
+
+void RouteTracker::begin(RouteId id) {
+    RouteStatus &status = routes_[id % kMaxRoutes];
+    // commands may arrive out of order, a newer route sharing the slot already pushed this one out
+    if (status.id < id) {
+        status = RouteStatus{id};
+    }
+}
+
+RouteStatus *RouteTracker::get(RouteId id) {
+    RouteStatus &status = routes_[id % kMaxRoutes];
+    return (id != 0 && status.id == id) ? &status : nullptr;
+}
+
+void RouteTracker::addMove(RouteId id) {
+    if (auto *status = get(id)) {
+        status->remaining++;
+    }
+}
+
+void RouteTracker::releaseMove(RouteId id, bool completed) {
+    if (auto *status = get(id)) {
+        status->remaining--;
+        status->superseded |= !completed;
+    }
+}
+
+void RouteTracker::reject(RouteId id) {
+    if (auto *status = get(id)) {
+        status->rejected = true;
+    }
+}
+
+void RouteTracker::markForwarded(RouteId id) {
+    if (auto *status = get(id)) {
+        status->forwarded = true;
+    }
+}
+
+std::optional<RouteStatus> RouteTracker::find(RouteId id) const {
+    const RouteStatus &status = routes_[id % kMaxRoutes];
+    if (id == 0 || status.id > id) {
+        return std::nullopt;
+    }
+    if (status.id < id) {
+        return RouteStatus{.id = id, .queued = true};
+    }
+    return status;
+}
+}  // namespace controller
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_CONTROLLER_ROUTETRACKER_H
+#define SWITCHCONTROL_CONTROLLER_ROUTETRACKER_H
+
+#include <array>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+
+namespace controller {
+/**
+ * @brief Identifier of a batch of switch changes, 0 is used for changes without a route.
+ */
+using RouteId = uint32_t;
+
+enum class RouteState { eInvalid = -1, ePending = 0, eDone = 1, eSuperseded = 2, eRejected = 3, eForwarded = 4 };
+
+NLOHMANN_JSON_SERIALIZE_ENUM(RouteState, {
+                                             {RouteState::eInvalid, nullptr},
+                                             {RouteState::ePending, "Pending"},
+                                             {RouteState::eDone, "Done"},
+                                             {RouteState::eSuperseded, "Superseded"},
+                                             {RouteState::eRejected, "Rejected"},
+                                             {RouteState::eForwarded, "Forwarded"},
+                                         })
+
+struct RouteStatus {
+    RouteId id{0};
+    int remaining{0};          ///< moves which are pending or still running
+    bool superseded{false};    ///< at least one move was replaced by a newer request
+    bool queued{false};        ///< the request wasn't handled by the control loop yet
+    bool rejected{false};      ///< the request conflicts with a locked route, has no target or couldn't be forwarded
+    bool forwarded{false};     ///< all actions were forwarded to other boards, nothing moves on this board
+
+    [[nodiscard]] RouteState state() const;
+};
+
+void to_json(nlohmann::json &j, const RouteStatus &status);
+
+/**
+ * @brief Tracks the completion of the most recent routes.
+ * Older routes are forgotten once more than kMaxRoutes newer routes were started. Routes are kept by their id, so a
+ * route handled after a newer one is still tracked correctly.
+ */
+class RouteTracker {
+   public:
+    static constexpr size_t kMaxRoutes = 16;
+
+    void begin(RouteId id);
+    /**
+     * @brief Count a move which has to finish before the route is done.
+     */
+    void addMove(RouteId id);
+    /**
+     * @brief Release a move of a route.
+     * @param completed false if the move was replaced before it finished
+     */
+    void releaseMove(RouteId id, bool completed);
+    /**
+     * @brief Mark a route which wasn't started because of a conflict or a failed forward.
+     */
+    void reject(RouteId id);
+    /**
+     * @brief Mark a route which only has actions for other boards, their completion isn't tracked.
+     */
+    void markForwarded(RouteId id);
+
+    /**
+     * @brief Status of an issued route. A route which wasn't begun yet is reported as queued, the caller has to check
+     * the id was issued at all.
+     * @return nothing if the route was already forgotten
+     */
+    [[nodiscard]] std::optional<RouteStatus> find(RouteId id) const;
+
+   private:
+    RouteStatus *get(RouteId id);
+
+    std::array<RouteStatus, kMaxRoutes> routes_{};
+};
+}  // namespace controller
+
+#endif  // SWITCHCONTROL_CONTROLLER_ROUTETRACKER_H
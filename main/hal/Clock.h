@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_HAL_CLOCK_H
+#define SWITCHCONTROL_HAL_CLOCK_H
+
+#include <chrono>
+
+namespace hal {
+/**
+ * @brief Source of the time seen by the control loop.
+ */
+class ClockBackend {
+   public:
+    virtual ~ClockBackend() = default;
+
+    [[nodiscard]] virtual std::chrono::steady_clock::time_point now() = 0;
+};
+
+/**
+ * @brief Time used by the controller and the channels.
+ * Uses the steady clock unless a simulation installed its own backend.
+ */
+class Clock {
+   public:
+    using time_point = std::chrono::steady_clock::time_point;
+    using duration = std::chrono::steady_clock::duration;
+
+    static time_point now() { return backend_ != nullptr ? backend_->now() : std::chrono::steady_clock::now(); }
+
+    /**
+     * @brief Replace the time source, nullptr restores the steady clock. Has to be called before any task starts.
+     */
+    static void setBackend(ClockBackend *backend) { backend_ = backend; }
+
+   private:
+    static inline ClockBackend *backend_{nullptr};
+};
+}  // namespace hal
+
+#endif  // SWITCHCONTROL_HAL_CLOCK_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_adc/adc_oneshot.h>
+#include <esp_log.h>
+
+#include <array>
+
+#include "Io.h"
+
+namespace hal {
+namespace {
+class EspPwm : public PwmBackend {
+   public:
+    void configureTimer() override {
+        ESP_LOGI("Servo", "Initializing LEDC");
+        ledc_timer_config_t timer_conf{};
+        timer_conf.clk_cfg = LEDC_AUTO_CLK;
+        timer_conf.duty_resolution = LEDC_TIMER_15_BIT;
+        timer_conf.freq_hz = kPwmFrequency;
+        timer_conf.speed_mode = LEDC_HIGH_SPEED_MODE;
+        timer_conf.timer_num = LEDC_TIMER_0;
+        ledc_timer_config(&timer_conf);
+        ESP_LOGI("Servo", "Initializing LEDC finished");
+    }
+
+    void configureChannel(ledc_channel_t channel, gpio_num_t gpio, uint32_t duty) override {
+        ledc_channel_config_t channel_conf{};
+        channel_conf.channel = channel;
+        channel_conf.duty = duty;
+        channel_conf.gpio_num = gpio;
+        channel_conf.intr_type = LEDC_INTR_DISABLE;
+        channel_conf.speed_mode = LEDC_HIGH_SPEED_MODE;
+        channel_conf.timer_sel = LEDC_TIMER_0;
+        ledc_channel_config(&channel_conf);
+    }
+
+    void setDuty(ledc_channel_t channel, uint32_t duty) override {
+        ledc_set_duty(LEDC_HIGH_SPEED_MODE, channel, duty);
+        ledc_update_duty(LEDC_HIGH_SPEED_MODE, channel);
+    }
+};
+
+class EspGpio : public GpioBackend {
+   public:
+    void reset(gpio_num_t gpio) override { gpio_reset_pin(gpio); }
+    void setMode(gpio_num_t gpio, PinMode mode) override {
+        gpio_set_direction(gpio, mode == PinMode::eInput ? GPIO_MODE_INPUT : GPIO_MODE_OUTPUT_OD);
+    }
+    void setLevel(gpio_num_t gpio, bool level) override { gpio_set_level(gpio, level); }
+    bool getLevel(gpio_num_t gpio) override { return gpio_get_level(gpio) != 0; }
+};
+
+class EspAdc : public AdcBackend {
+   public:
+    void configureChannel(int channel) override {
+        if (unit_ == nullptr) {
+            adc_oneshot_unit_init_cfg_t unitCfg{};
+            unitCfg.unit_id = ADC_UNIT_1;
+            if (adc_oneshot_new_unit(&unitCfg, &unit_) != ESP_OK) {
+                ESP_LOGE("Adc", "Initializing ADC1 failed");
+                unit_ = nullptr;
+                return;
+            }
+        }
+        if (configured_[channel]) {
+            return;
+        }
+        adc_oneshot_chan_cfg_t chanCfg{};
+        chanCfg.atten = ADC_ATTEN_DB_12;
+        chanCfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+        adc_oneshot_config_channel(unit_, static_cast<adc_channel_t>(channel), &chanCfg);
+
+        adc_cali_line_fitting_config_t caliCfg{};
+        caliCfg.unit_id = ADC_UNIT_1;
+        caliCfg.atten = ADC_ATTEN_DB_12;
+        caliCfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+        if (adc_cali_create_scheme_line_fitting(&caliCfg, &cali_[channel]) != ESP_OK) {
+            ESP_LOGW("Adc", "No calibration for ADC1 channel %d, using raw values", channel);
+            cali_[channel] = nullptr;
+        }
+        configured_[channel] = true;
+    }
+
+    int readMillivolts(int channel) override {
+        int raw = 0;
+        if (unit_ == nullptr || !configured_[channel] ||
+            adc_oneshot_read(unit_, static_cast<adc_channel_t>(channel), &raw) != ESP_OK) {
+            return -1;
+        }
+        int mv = raw;
+        if (cali_[channel] != nullptr) {
+            adc_cali_raw_to_voltage(cali_[channel], raw, &mv);
+        }
+        return mv;
+    }
+
+   private:
+    adc_oneshot_unit_handle_t unit_{nullptr};
+    std::array<adc_cali_handle_t, kAdcChannels> cali_{};
+    std::array<bool, kAdcChannels> configured_{};
+};
+}  // namespace
+
+PwmBackend &platformPwm() {
+    static EspPwm pwm;
+    return pwm;
+}
+
+GpioBackend &platformGpio() {
+    static EspGpio gpio;
+    return gpio;
+}
+
+AdcBackend &platformAdc() {
+    static EspAdc adc;
+    return adc;
+}
+}  // namespace hal
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_HAL_IO_H
+#define SWITCHCONTROL_HAL_IO_H
+
+#include <hal/ledc_types.h>
+#include <soc/gpio_num.h>
+
+#include <cstdint>
+
+namespace hal {
+const static inline int kPwmFrequency = 50;
+const static inline int kPwmResolution = 15;
+const static inline int kAdcChannels = 8;
+
+/**
+ * @brief PWM outputs driving the servos.
+ */
+class PwmBackend {
+   public:
+    virtual ~PwmBackend() = default;
+
+    /**
+     * @brief Configure the timer shared by all servo channels, kPwmFrequency with kPwmResolution bits.
+     */
+    virtual void configureTimer() = 0;
+    virtual void configureChannel(ledc_channel_t channel, gpio_num_t gpio, uint32_t duty) = 0;
+    virtual void setDuty(ledc_channel_t channel, uint32_t duty) = 0;
+};
+
+enum class PinMode { eInput, eOutputOpenDrain };
+
+/**
+ * @brief Digital pins of the smart buttons.
+ */
+class GpioBackend {
+   public:
+    virtual ~GpioBackend() = default;
+
+    virtual void reset(gpio_num_t gpio) = 0;
+    virtual void setMode(gpio_num_t gpio, PinMode mode) = 0;
+    virtual void setLevel(gpio_num_t gpio, bool level) = 0;
+    [[nodiscard]] virtual bool getLevel(gpio_num_t gpio) = 0;
+};
+
+/**
+ * @brief Analog inputs of ADC1 sensing the current or position of servos. ADC2 can't be used while WiFi is active.
+ */
+class AdcBackend {
+   public:
+    virtual ~AdcBackend() = default;
+
+    virtual void configureChannel(int channel) = 0;
+    /**
+     * @brief Read a calibrated voltage.
+     * @return the voltage in mV or -1 if the channel can't be read
+     */
+    [[nodiscard]] virtual int readMillivolts(int channel) = 0;
+};
+
+PwmBackend &pwm();
+GpioBackend &gpio();
+AdcBackend &adc();
+
+/**
+ * @brief Replace the io backends, nullptr restores the backend of the platform. Has to be called before any channel
+ * is created.
+ */
+void setBackends(PwmBackend *pwm, GpioBackend *gpio, AdcBackend *adc = nullptr);
+
+/**
+ * @brief Backends of the platform, the drivers on the esp and the simulation on the linux target.
+ */
+PwmBackend &platformPwm();
+GpioBackend &platformGpio();
+AdcBackend &platformAdc();
+}  // namespace hal
+
+#endif  // SWITCHCONTROL_HAL_IO_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_HAL_SIM_H
+#define SWITCHCONTROL_HAL_SIM_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+#include "Clock.h"
+#include "Io.h"
+
+namespace hal {
+/**
+ * @brief Virtual time which only advances when told so.
+ */
+class SimClock : public ClockBackend {
+   public:
+    [[nodiscard]] std::chrono::steady_clock::time_point now() override { return now_; }
+    void advance(std::chrono::steady_clock::duration d) { now_ += d; }
+
+   private:
+    // start away from the epoch, default constructed time points are used as unset values
+    std::chrono::steady_clock::time_point now_{std::chrono::hours(1)};
+};
+
+/**
+ * @brief Records the duty of all PWM channels.
+ */
+class SimPwm : public PwmBackend {
+   public:
+    void configureTimer() override {}
+    void configureChannel(ledc_channel_t channel, gpio_num_t, uint32_t duty) override { setDuty(channel, duty); }
+    void setDuty(ledc_channel_t channel, uint32_t duty) override {
+        duty_[channel] = duty;
+        writes_++;
+    }
+
+    /**
+     * @brief Get the pulse width currently generated on a channel in us.
+     * The duty is truncated when written, rounding up recovers the whole us it was computed from.
+     */
+    [[nodiscard]] int pulseWidth(ledc_channel_t channel) const {
+        constexpr uint32_t kPeriodUs = 1000000 / kPwmFrequency;
+        return static_cast<int>((duty_[channel] * kPeriodUs + (1u << kPwmResolution) - 1) >> kPwmResolution);
+    }
+    [[nodiscard]] size_t writes() const { return writes_; }
+
+   private:
+    std::array<uint32_t, LEDC_CHANNEL_MAX> duty_{};
+    size_t writes_{0};
+};
+
+/**
+ * @brief Pins with an externally driven input level, e.g. a pressed button pulling the pin low.
+ */
+class SimGpio : public GpioBackend {
+   public:
+    SimGpio() { external_.fill(true); }
+
+    void reset(gpio_num_t gpio) override { mode_[gpio] = PinMode::eInput; }
+    void setMode(gpio_num_t gpio, PinMode mode) override { mode_[gpio] = mode; }
+    void setLevel(gpio_num_t gpio, bool level) override { output_[gpio] = level; }
+    bool getLevel(gpio_num_t gpio) override {
+        // an open drain output only pulls low
+        bool level = external_[gpio];
+        return mode_[gpio] == PinMode::eOutputOpenDrain ? level && output_[gpio] : level;
+    }
+
+    /**
+     * @brief Drive a pin from outside, pins are pulled up if not driven.
+     */
+    void setInput(gpio_num_t gpio, bool level) { external_[gpio] = level; }
+    [[nodiscard]] bool getOutput(gpio_num_t gpio) const { return output_[gpio]; }
+
+   private:
+    std::array<bool, GPIO_NUM_MAX> external_{};
+    std::array<bool, GPIO_NUM_MAX> output_{};
+    std::array<PinMode, GPIO_NUM_MAX> mode_{};
+};
+
+/**
+ * @brief Analog inputs with externally set voltages, e.g. a current sense amplifier of a stalled servo.
+ */
+class SimAdc : public AdcBackend {
+   public:
+    void configureChannel(int channel) override { configured_[channel] = true; }
+    int readMillivolts(int channel) override {
+        reads_++;
+        return configured_[channel] ? millivolts_[channel] : -1;
+    }
+
+    void setMillivolts(int channel, int mv) { millivolts_[channel] = mv; }
+    [[nodiscard]] size_t reads() const { return reads_; }
+
+   private:
+    std::array<int, kAdcChannels> millivolts_{};
+    std::array<bool, kAdcChannels> configured_{};
+    size_t reads_{0};
+};
+}  // namespace hal
+
+#endif  // SWITCHCONTROL_HAL_SIM_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ButtonSampler.h"
+
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+
+#include <chrono>
+
+#include "hal/Clock.h"
+#include "hal/Io.h"
+#include "util/Metrics.h"
+
+namespace io {
+
+ButtonSampler::~ButtonSampler() {
+    if (task_ != nullptr) {
+        vTaskDelete(task_);
+    }
+}
+
+void ButtonSampler::start() {
+    if (task_ != nullptr) {
+        return;
+    }
+    xTaskCreatePinnedToCore(&ButtonSampler::taskMain, "buttons", 3072, this, kTaskPriority, &task_, kTaskCore);
+}
+
+void ButtonSampler::attach(config::ChannelId channel, bool invertedInput, bool invertedOutput) {
+    Slot &slot = slots_[channel];
+    slot.invertedInput.store(invertedInput, std::memory_order_relaxed);
+    slot.invertedOutput.store(invertedOutput, std::memory_order_relaxed);
+    slot.state.store(MatchingState::ePending, std::memory_order_relaxed);
+    slot.active.store(true, std::memory_order_release);
+}
+
+void ButtonSampler::detach(config::ChannelId channel) {
+    slots_[channel].active.store(false, std::memory_order_release);
+    if (task_ == nullptr || xTaskGetCurrentTaskHandle() == task_) {
+        return;
+    }
+    // a pass which read the slot before may still drive the pin, the next finished pass has ended it
+    const uint32_t pass = passes_.load(std::memory_order_acquire);
+    while (passes_.load(std::memory_order_acquire) == pass) {
+        vTaskDelay(1);
+    }
+}
+
+void ButtonSampler::setMatchingState(config::ChannelId channel, MatchingState state) {
+    slots_[channel].state.store(state, std::memory_order_relaxed);
+}
+
+void ButtonSampler::taskMain(void *arg) {
+    auto *sampler = static_cast<ButtonSampler *>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+    int64_t lastPass = 0;
+    while (true) {
+        int64_t now = util::metricsNow();
+        if (lastPass != 0) {
+            int64_t deviation = now - lastPass - kSamplePeriodMs * 1000;
+            util::metrics().loopJitter.record(deviation < 0 ? -deviation : deviation);
+        }
+        lastPass = now;
+        sampler->samplePass();
+        sampler->passes_.fetch_add(1, std::memory_order_release);
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(kSamplePeriodMs));
+    }
+}
+
+static bool currentBlinkState() {
+    auto now = hal::Clock::now();
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    return (millis % 1000) > 500;
+}
+
+void ButtonSampler::samplePass() {
+    // Release all buttons at once so they can share a single settle time.
+    bool anyActive = false;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (!slots_[i].active.load(std::memory_order_acquire)) {
+            slots_[i].tickPressed = 0;
+            continue;
+        }
+        anyActive = true;
+        gpio_num_t gpio = config::kChannels[i].gpio;
+        hal::gpio().setLevel(gpio, false);
+        hal::gpio().setMode(gpio, hal::PinMode::eInput);
+    }
+    if (!anyActive) {
+        return;
+    }
+
+    esp_rom_delay_us(kSettleTimeUs);
+
+    const bool blink = currentBlinkState();
+    bool pressed = false;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot &slot = slots_[i];
+        if (!slot.active.load(std::memory_order_acquire)) {
+            continue;
+        }
+        gpio_num_t gpio = config::kChannels[i].gpio;
+        if (hal::gpio().getLevel(gpio) ^ slot.invertedInput.load(std::memory_order_relaxed)) {
+            slot.tickPressed++;
+        } else {
+            slot.tickPressed = 0;
+        }
+
+        hal::gpio().setMode(gpio, hal::PinMode::eOutputOpenDrain);
+        bool led;
+        switch (slot.state.load(std::memory_order_relaxed)) {
+            case MatchingState::ePending:
+                led = blink;
+                break;
+            case MatchingState::eMatch:
+                led = true;
+                break;
+            case MatchingState::eNoMatch:
+            default:
+                led = false;
+                break;
+        }
+        hal::gpio().setLevel(gpio, !(slot.invertedOutput.load(std::memory_order_relaxed) && led));
+
+        if (slot.tickPressed == kRequiredTicks) {
+            if (!events_.push({static_cast<config::ChannelId>(i), util::metricsNow()})) {
+                ESP_LOGW("Buttons", "Event queue full, dropping press on %s", config::kChannels[i].name);
+            }
+            pressed = true;
+        }
+    }
+
+    TaskHandle_t consumer = consumer_.load();
+    if (pressed && consumer != nullptr) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+}  // namespace io
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_IO_BUTTONSAMPLER_H
+#define SWITCHCONTROL_IO_BUTTONSAMPLER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "SmartButtonChannel.h"
+#include "config/ChannelRegistry.h"
+#include "util/SpscQueue.h"
+
+namespace io {
+
+/**
+ * @brief A debounced button press reported by the sampler.
+ */
+struct ButtonEvent {
+    config::ChannelId channel{0};
+    int64_t pressedAt{0};  ///< metrics timestamp of the debounced press
+};
+
+/**
+ * @brief Samples all smart buttons in a dedicated high priority task.
+ * Every pass switches all attached pins to input, waits once for the inputs to settle, reads every pin and
+ * drives the button LEDs again. Debounced presses are published through a lock-free queue.
+ */
+class ButtonSampler {
+   public:
+    const inline static int kRequiredTicks = 3;
+    const inline static int kSamplePeriodMs = 20;
+    const inline static int kSettleTimeUs = 50;
+    const inline static int kTaskPriority = 10;
+    const inline static BaseType_t kTaskCore = 1;
+
+    ButtonSampler() = default;
+    ~ButtonSampler();
+
+    /**
+     * @brief Start the sampling task.
+     */
+    void start();
+
+    /**
+     * @brief Start sampling a button.
+     * @param channel the channel of the button
+     * @param invertedInput whether the input is logically inverted
+     * @param invertedOutput whether the LED output is logically inverted
+     */
+    void attach(config::ChannelId channel, bool invertedInput, bool invertedOutput);
+    /**
+     * @brief Stop sampling a button. The pin is left untouched.
+     * Waits until a running pass of the sampling task ended, afterwards the pin can be handed to another user.
+     * @param channel the channel of the button
+     */
+    void detach(config::ChannelId channel);
+
+    /**
+     * @brief Set the state which should be shown on the LED of a button.
+     */
+    void setMatchingState(config::ChannelId channel, MatchingState state);
+
+    /**
+     * @brief Set the task which gets notified for every new button press.
+     */
+    void setConsumer(TaskHandle_t task) { consumer_.store(task); }
+
+    /**
+     * @brief Get the next debounced button press.
+     * @param event receives the event
+     * @return false if no press is pending
+     */
+    bool popEvent(ButtonEvent &event) { return events_.pop(event); }
+
+    /**
+     * @brief Sample all buttons once. Called by the sampling task, a simulation calls it directly instead.
+     */
+    void samplePass();
+
+   private:
+    struct Slot {
+        std::atomic<bool> active{false};
+        std::atomic<bool> invertedInput{false};
+        std::atomic<bool> invertedOutput{false};
+        std::atomic<MatchingState> state{MatchingState::ePending};
+        int tickPressed{0};
+    };
+
+    std::array<Slot, config::kChannelCount> slots_{};
+    util::SpscQueue<ButtonEvent, 32> events_;
+    TaskHandle_t task_{nullptr};
+    std::atomic<TaskHandle_t> consumer_{nullptr};
+    // number of passes finished by the sampling task
+    std::atomic<uint32_t> passes_{0};
+
+    static void taskMain(void *arg);
+};
+}  // namespace io
+
+#endif  // SWITCHCONTROL_IO_BUTTONSAMPLER_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SenseSampler.h"
+
+#include <esp_log.h>
+
+#include <cstdlib>
+
+#include "hal/Io.h"
+
+namespace io {
+
+SenseSampler::~SenseSampler() {
+    if (task_ != nullptr) {
+        vTaskDelete(task_);
+    }
+}
+
+void SenseSampler::start() {
+    if (task_ != nullptr) {
+        return;
+    }
+    xTaskCreatePinnedToCore(&SenseSampler::taskMain, "sense", 3072, this, kTaskPriority, &task_, kTaskCore);
+}
+
+void SenseSampler::configure(config::ChannelId channel, const config::ConfigServo &cfg) {
+    Slot &slot = slots_[channel];
+    slot.armed.store(0, std::memory_order_release);
+    slot.adcChannel.store(cfg.senseChannel, std::memory_order_relaxed);
+    slot.threshold.store(cfg.senseThreshold, std::memory_order_relaxed);
+    slot.mode.store(cfg.sense, std::memory_order_relaxed);
+    if (cfg.sense != config::SenseMode::eNone) {
+        hal::adc().configureChannel(cfg.senseChannel);
+    }
+}
+
+uint32_t SenseSampler::arm(config::ChannelId channel, int target) {
+    Slot &slot = slots_[channel];
+    uint32_t generation = nextGeneration_++;
+    if (nextGeneration_ == 0) {
+        nextGeneration_ = 1;
+    }
+    slot.target.store(target, std::memory_order_relaxed);
+    slot.armed.store(generation, std::memory_order_release);
+    return generation;
+}
+
+void SenseSampler::disarm(config::ChannelId channel) { slots_[channel].armed.store(0, std::memory_order_release); }
+
+void SenseSampler::taskMain(void *arg) {
+    auto *sampler = static_cast<SenseSampler *>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+        sampler->samplePass();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(kSamplePeriodMs));
+    }
+}
+
+void SenseSampler::samplePass() {
+    bool reported = false;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot &slot = slots_[i];
+        const uint32_t armed = slot.armed.load(std::memory_order_acquire);
+        const config::SenseMode mode = slot.mode.load(std::memory_order_relaxed);
+        if (armed == 0 || mode == config::SenseMode::eNone) {
+            continue;
+        }
+        if (armed != slot.seen) {
+            slot.seen = armed;
+            slot.samples = 0;
+            slot.matches = 0;
+        }
+        // the inrush current of the servo looks like a stall
+        if (++slot.samples <= kBlankingMs / kSamplePeriodMs) {
+            continue;
+        }
+
+        int mv = hal::adc().readMillivolts(slot.adcChannel.load(std::memory_order_relaxed));
+        if (mv < 0) {
+            continue;
+        }
+        const int threshold = slot.threshold.load(std::memory_order_relaxed);
+        bool match = mode == config::SenseMode::eCurrent
+                         ? mv >= threshold
+                         : std::abs(mv - slot.target.load(std::memory_order_relaxed)) <= threshold;
+        slot.matches = match ? slot.matches + 1 : 0;
+        if (slot.matches < kRequiredSamples) {
+            continue;
+        }
+
+        // a new arming in the meantime keeps the slot armed
+        uint32_t expected = armed;
+        slot.armed.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+        SettleReason reason = mode == config::SenseMode::eCurrent ? SettleReason::eStall : SettleReason::eInPosition;
+        if (!events_.push({static_cast<config::ChannelId>(i), reason, armed})) {
+            ESP_LOGW("Sense", "Event queue full, dropping event of %s", config::kChannels[i].name);
+        }
+        reported = true;
+    }
+
+    TaskHandle_t consumer = consumer_.load();
+    if (reported && consumer != nullptr) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+}  // namespace io
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_IO_SENSESAMPLER_H
+#define SWITCHCONTROL_IO_SENSESAMPLER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "ServoOutChannel.h"
+#include "config/ChannelRegistry.h"
+#include "config/ServoConfig.h"
+#include "util/SpscQueue.h"
+
+namespace io {
+
+/**
+ * @brief A servo reported in position by its sense input.
+ */
+struct SenseEvent {
+    config::ChannelId channel{0};
+    SettleReason reason{SettleReason::eNone};
+    uint32_t generation{0};  ///< the arming this event belongs to
+};
+
+/**
+ * @brief Samples the sense inputs of overdrawing servos in a dedicated high priority task.
+ * A servo is armed when its overdraw starts, after the ramp of its motion profile ended. After a blanking time covering the inrush current, a reading above the
+ * stall threshold or within the tolerance around the target position for kRequiredSamples passes reports the servo
+ * in position and disarms it. Events are published through a lock-free queue.
+ */
+class SenseSampler {
+   public:
+    const inline static int kRequiredSamples = 3;
+    const inline static int kSamplePeriodMs = 5;
+    const inline static int kBlankingMs = 60;
+    const inline static int kTaskPriority = 10;
+    const inline static BaseType_t kTaskCore = 1;
+
+    SenseSampler() = default;
+    ~SenseSampler();
+
+    /**
+     * @brief Start the sampling task.
+     */
+    void start();
+
+    /**
+     * @brief Set the sense input of a servo, the servo is disarmed.
+     * @param channel the channel of the servo
+     * @param cfg the configuration of the servo
+     */
+    void configure(config::ChannelId channel, const config::ConfigServo &cfg);
+
+    /**
+     * @brief Start watching the sense input of a servo.
+     * @param channel the channel of the servo
+     * @param target reading of a position input in mV, ignored for current inputs
+     * @return the generation of the arming, repeated in its event
+     */
+    uint32_t arm(config::ChannelId channel, int target);
+    void disarm(config::ChannelId channel);
+
+    /**
+     * @brief Set the task which gets notified for every new event.
+     */
+    void setConsumer(TaskHandle_t task) { consumer_.store(task); }
+
+    bool popEvent(SenseEvent &event) { return events_.pop(event); }
+
+    /**
+     * @brief Sample all armed inputs once. Called by the sampling task, a simulation calls it directly instead.
+     */
+    void samplePass();
+
+   private:
+    struct Slot {
+        std::atomic<config::SenseMode> mode{config::SenseMode::eNone};
+        std::atomic<int> adcChannel{0};
+        std::atomic<int> threshold{0};
+        std::atomic<int> target{0};
+        std::atomic<uint32_t> armed{0};  // generation of the arming, 0 if disarmed
+        // only used by the sampling task
+        uint32_t seen{0};
+        int samples{0};
+        int matches{0};
+    };
+
+    std::array<Slot, config::kChannelCount> slots_{};
+    uint32_t nextGeneration_{1};
+    util::SpscQueue<SenseEvent, 16> events_;
+    TaskHandle_t task_{nullptr};
+    std::atomic<TaskHandle_t> consumer_{nullptr};
+
+    static void taskMain(void *arg);
+};
+}  // namespace io
+
+#endif  // SWITCHCONTROL_IO_SENSESAMPLER_H
@@ -20,100 +20,183 @@
 
 #include "ServoOutChannel.h"
 
-#include <driver/gpio.h>
-#include <driver/ledc.h>
 #include <esp_log.h>
 
-#include <cstring>
-#include <map>
+#include <algorithm>
+#include <cmath>
+
+#include "hal/Clock.h"
+#include "hal/Io.h"
+#include "util/EventLog.h"
 
 namespace io {
 
-ServoOutputChannel::ServoOutputChannel(const config::ConfigGpio &config) : config_(config) {
-    initChannel();
+ServoOutputChannel::ServoOutputChannel(const config::ConfigGpio &config, const config::ServoPosition &restored)
+    : config_(config), ledcChannel_(config::kChannels[config.channel].ledc) {
+    initChannel(restored);
 }
 
 ServoOutputChannel::~ServoOutputChannel() = default;
 
-const std::map<gpio_num_t, ledc_channel_t> kGpioToLedCChannelMap = {
-    {GPIO_NUM_25, LEDC_CHANNEL_0}, {GPIO_NUM_13, LEDC_CHANNEL_1}, {GPIO_NUM_23, LEDC_CHANNEL_2},
-    {GPIO_NUM_19, LEDC_CHANNEL_3}, {GPIO_NUM_18, LEDC_CHANNEL_4}, {GPIO_NUM_17, LEDC_CHANNEL_5},
-    {GPIO_NUM_16, LEDC_CHANNEL_6}, {GPIO_NUM_4, LEDC_CHANNEL_7},
-};
+void ServoOutputChannel::initLedc() { hal::pwm().configureTimer(); }
+
+static int getDuty(int us) { return (1 << hal::kPwmResolution) * us / (1000000 / hal::kPwmFrequency); }
 
-void ServoOutputChannel::initLedc() {
-    ESP_LOGI("Servo", "Initializing LEDC");
+void ServoOutputChannel::initChannel(const config::ServoPosition &restored) {
+    ESP_LOGI("Servo", "Initializing Channel %s", config::channelName(config_.channel));
+    switch (restored.direction) {
+        case config::SwitchDirection::eLeft:
+            currPos_ = config_.servoCfg_->servoLeft;
+            break;
+        case config::SwitchDirection::eRight:
+            currPos_ = config_.servoCfg_->servoRight;
+            break;
+        case config::SwitchDirection::eCustom:
+            currPos_ = restored.time;
+            customTime_ = restored.time;
+            break;
+        default:
+            // driving an unknown servo to any position would move it, it stays without pulse until its first move
+            currPos_ = 0;
+            break;
+    }
+    currDir_ = currPos_ == 0 ? config::SwitchDirection::eUnknown : restored.direction;
+    hal::gpio().reset(config_.gpio());
+    hal::pwm().configureChannel(ledcChannel_, config_.gpio(), currPos_ == 0 ? 0 : getDuty(currPos_));
+    ESP_LOGI("Servo", "Initializing Channel %s finished at %d us", config::channelName(config_.channel), currPos_);
+}
 
-    ledc_timer_config_t timer_conf{};
-    memset(&timer_conf, 0, sizeof(ledc_timer_config_t));
-    timer_conf.clk_cfg = LEDC_AUTO_CLK;
-    timer_conf.duty_resolution = LEDC_TIMER_15_BIT;
-    timer_conf.freq_hz = 50;
-    timer_conf.speed_mode = LEDC_HIGH_SPEED_MODE;
-    timer_conf.timer_num = LEDC_TIMER_0;
-    ledc_timer_config(&timer_conf);
+void ServoOutputChannel::writeDuty(int us) {
+    hal::pwm().setDuty(ledcChannel_, getDuty(us));
+    currPos_ = us;
+}
 
-    ESP_LOGI("Servo", "Initializing LEDC finished");
+void ServoOutputChannel::setServo(int us) {
+    ESP_LOGI("Servo", "Set Servo %s to state %d us; dc %d", config::channelName(config_.channel), us, getDuty(us));
+    ramp_.reset();
+    writeDuty(us);
 }
 
-static int getDuty(int us) {
-    const int kBitSize = 15;
-    return (1 << kBitSize) * us / 20000;
+/**
+ * @brief Map the elapsed fraction of a ramp to the fraction of the distance covered.
+ */
+static double rampProgress(config::MotionProfile profile, double t) {
+    switch (profile) {
+        case config::MotionProfile::eLinear:
+            return t;
+        case config::MotionProfile::eTrapezoidal: {
+            // accelerate during the first and decelerate during the last quarter
+            const double a = 0.25;
+            const double v = 1 / (1 - a);
+            if (t < a) return v * t * t / (2 * a);
+            if (t > 1 - a) return 1 - v * (1 - t) * (1 - t) / (2 * a);
+            return v * (t - a / 2);
+        }
+        case config::MotionProfile::eSCurve:
+            // minimum jerk trajectory
+            return t * t * t * (10 - 15 * t + 6 * t * t);
+        case config::MotionProfile::eNone:
+        default:
+            return 1;
+    }
 }
 
-void ServoOutputChannel::initChannel() const {
-    ESP_LOGI("Servo", "Initializing Channel %s", config_.channel.c_str());
-    gpio_reset_pin(config_.gpio());
+std::chrono::steady_clock::time_point ServoOutputChannel::moveTo(int us) {
+    auto now = hal::Clock::now();
+    const config::ConfigServo &cfg = *config_.servoCfg_;
+    // without a known position there is nothing to ramp from
+    if (cfg.motionProfile == config::MotionProfile::eNone || !config::isValidServoTime(currPos_)) {
+        setServo(us);
+        rampLength_ = {};
+        return now;
+    }
 
-    ledc_channel_config_t channel_conf{};
-    memset(&channel_conf, 0, sizeof(ledc_timer_config_t));
-    channel_conf.channel = kGpioToLedCChannelMap.at(config_.gpio());
-    channel_conf.duty = getDuty(config_.servoCfg_->servoLeft);
-    channel_conf.gpio_num = config_.gpio();
-    channel_conf.intr_type = LEDC_INTR_DISABLE;
-    channel_conf.speed_mode = LEDC_HIGH_SPEED_MODE;
-    channel_conf.timer_sel = LEDC_TIMER_0;
-    ledc_channel_config(&channel_conf);
-    ESP_LOGI("Servo", "Initializing Channel %s finished", config_.channel.c_str());
+    ESP_LOGI("Servo", "Ramp Servo %s from %d us to %d us", config::channelName(config_.channel), currPos_, us);
+    auto length = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(std::abs(us - currPos_) / static_cast<double>(cfg.speed)));
+    ramp_ = Ramp{currPos_, us, now, length};
+    rampLength_ = length;
+    stepMotion(now);
+    return now + length;
 }
 
-void ServoOutputChannel::setServo(int us) {
-    ESP_LOGI("Servo", "Set Servo %s to state %d us; dc %d", config_.channel.c_str(), us, getDuty(us));
-    ledc_channel_t ledcChannel = kGpioToLedCChannelMap.at(config_.gpio());
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, ledcChannel, getDuty(us));
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, ledcChannel);
-    currPos_ = us;
+bool ServoOutputChannel::stepMotion(std::chrono::steady_clock::time_point now) {
+    if (!ramp_.has_value()) {
+        return false;
+    }
+    if (now >= ramp_->start + ramp_->length) {
+        writeDuty(ramp_->to);
+        ramp_.reset();
+        return false;
+    }
+    double t = std::chrono::duration<double>(now - ramp_->start) / std::chrono::duration<double>(ramp_->length);
+    double progress = rampProgress(config_.servoCfg_->motionProfile, std::clamp(t, 0.0, 1.0));
+    writeDuty(ramp_->from + static_cast<int>(std::lround((ramp_->to - ramp_->from) * progress)));
+    return true;
 }
 
 void ServoOutputChannel::actionLeft() {
-    setServo(config_.servoCfg_->servoOverdrawLeft);
-    overdrawTime_ = std::chrono::steady_clock::now();
+    moveStartedAt_ = hal::Clock::now();
+    // the overdraw starts once the servo reached its position
+    overdrawTime_ = moveTo(config_.servoCfg_->servoOverdrawLeft);
     currDir_ = config::SwitchDirection::eLeft;
     overdraw_ = true;
 }
 
 void ServoOutputChannel::actionRight() {
-    setServo(config_.servoCfg_->servoOverdrawRight);
-    overdrawTime_ = std::chrono::steady_clock::now();
+    moveStartedAt_ = hal::Clock::now();
+    overdrawTime_ = moveTo(config_.servoCfg_->servoOverdrawRight);
     currDir_ = config::SwitchDirection::eRight;
     overdraw_ = true;
 }
 
 void ServoOutputChannel::checkOverdraw() {
-    if (!overdraw_) return;
+    if (overdraw_ && hal::Clock::now() >= getOverdrawReleaseTime()) {
+        releaseOverdraw(SettleReason::eTimeout);
+    }
+}
+
+bool ServoOutputChannel::settle(SettleReason reason) {
+    if (!overdraw_) {
+        return false;
+    }
+    ESP_LOGI("Servo", "Servo %s settled early", config::channelName(config_.channel));
+    releaseOverdraw(reason);
+    return true;
+}
+
+void ServoOutputChannel::releaseOverdraw(SettleReason reason) {
     int newPos = -1;
     if (currDir_ == config::SwitchDirection::eRight) {
         newPos = config_.servoCfg_->servoRight;
     } else if (currDir_ == config::SwitchDirection::eLeft) {
         newPos = config_.servoCfg_->servoLeft;
     }
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> lastChange = now - overdrawTime_;
-    if (lastChange.count() > config_.servoCfg_->overdrawTime) {
-        setServo(newPos);
-        overdraw_ = false;
+    setServo(newPos);
+    overdraw_ = false;
+    lastMoveDuration_ = hal::Clock::now() - moveStartedAt_;
+    lastSettle_ = reason;
+    util::events().record(util::EventType::eOverdrawEnd, config_.channel, static_cast<uint16_t>(reason));
+    if (reason == SettleReason::eStall) {
+        stalls_++;
     }
 }
+
+int ServoOutputChannel::getSenseTarget() const {
+    const config::ConfigServo &cfg = *config_.servoCfg_;
+    return currDir_ == config::SwitchDirection::eLeft ? cfg.senseLeft : cfg.senseRight;
+}
+
+std::chrono::steady_clock::time_point ServoOutputChannel::getOverdrawReleaseTime() const {
+    return overdrawTime_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(config_.servoCfg_->overdrawTime));
+}
+
+std::chrono::steady_clock::duration ServoOutputChannel::getMoveDuration() const {
+    double seconds = std::max(config_.servoCfg_->overdrawTime, kMinMoveDuration);
+    return rampLength_ +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
 void ServoOutputChannel::executePendingAction() {
     if (!pendingAction_.has_value()) {
         return;
@@ -130,22 +213,52 @@ void ServoOutputChannel::executePendingAction() {
             actionRight();
             break;
         case config::SwitchDirection::eCustom:
-            setServo(pendingAction_->customTime);
+            moveTo(pendingAction_->customTime);
             currDir_ = config::SwitchDirection::eCustom;
+            customTime_ = pendingAction_->customTime;
             overdraw_ = false;
             break;
     }
     removePendingAction();
 }
 
-void to_json(nlohmann::json &j, const ServoOutputChannel &ch) {
-    j["time"] = ch.getCurrPos();
-    j["position"] = ch.getDirection();
-    auto pending = ch.getPendingAction();
-    if (pending.has_value()) {
-        j["nextPosition"] = pending->direction;
+ServoStatus ServoOutputChannel::getStatus() const {
+    ServoStatus status{};
+    status.channel = config_.channel;
+    status.time = currPos_;
+    status.position = currDir_;
+    if (pendingAction_.has_value()) {
+        status.nextPosition = pendingAction_->direction;
+    }
+    status.overdrawing = overdraw_;
+    status.moving = isMoving();
+    if (lastMoveDuration_.has_value()) {
+        status.moveDurationMs = std::chrono::duration_cast<std::chrono::milliseconds>(*lastMoveDuration_).count();
+    }
+    status.settledBy = lastSettle_;
+    if (hasSense()) {
+        status.stalls = stalls_;
+    }
+    return status;
+}
+
+void to_json(nlohmann::json &j, const ServoStatus &status) {
+    j["channel"] = config::channelName(status.channel);
+    j["time"] = status.time;
+    j["position"] = status.position;
+    if (status.nextPosition.has_value()) {
+        j["nextPosition"] = *status.nextPosition;
+    }
+    j["overdrawing"] = status.overdrawing;
+    if (status.moveDurationMs.has_value()) {
+        j["moveDuration"] = *status.moveDurationMs;
+        j["settledBy"] = status.settledBy;
+    }
+    if (status.stalls.has_value()) {
+        j["stalls"] = *status.stalls;
     }
-    j["overdrawing"] = ch.isOverdrawing();
 }
 
+void to_json(nlohmann::json &j, const ServoOutputChannel &ch) { to_json(j, ch.getStatus()); }
+
 }  // namespace io
\ No newline at end of file
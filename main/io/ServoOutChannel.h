@@ -21,49 +21,166 @@
 #ifndef SWITCHCONTROL_IO_SERVOOUTCHANNEL_H
 #define SWITCHCONTROL_IO_SERVOOUTCHANNEL_H
 
+#include <hal/ledc_types.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
 #include "config/GpioConfig.h"
 #include "config/ServoConfig.h"
 
 namespace io {
 
+/**
+ * @brief What ended the overdraw of a move.
+ */
+enum class SettleReason { eNone, eTimeout, eStall, eInPosition };
+
+NLOHMANN_JSON_SERIALIZE_ENUM(SettleReason, {
+                                               {SettleReason::eNone, nullptr},
+                                               {SettleReason::eTimeout, "Timeout"},
+                                               {SettleReason::eStall, "Stall"},
+                                               {SettleReason::eInPosition, "InPosition"},
+                                           })
+
+/**
+ * @brief State of a servo as reported to the web interface. A plain value, so the control loop can copy it without
+ * allocating; the json is built by the reader.
+ */
+struct ServoStatus {
+    config::ChannelId channel{0};
+    int time{0};
+    config::SwitchDirection position{config::SwitchDirection::eUnknown};
+    std::optional<config::SwitchDirection> nextPosition{};
+    bool overdrawing{false};
+    bool moving{false};
+    std::optional<int64_t> moveDurationMs{};  ///< duration of the last move until its overdraw ended
+    SettleReason settledBy{SettleReason::eNone};
+    std::optional<uint32_t> stalls{};  ///< only reported for servos with a sense input
+
+    bool operator==(const ServoStatus &) const = default;
+};
+
+void to_json(nlohmann::json &j, const ServoStatus &status);
+
 /**
  * @brief This class represents a single servo output channel
  */
 class ServoOutputChannel {
    public:
-    explicit ServoOutputChannel(const config::ConfigGpio &config);
+    const inline static double kMinMoveDuration = 0.3;
+    /// Interval in which ramps are advanced, equal to the PWM period since the duty only updates once per period.
+    const inline static std::chrono::milliseconds kMotionStep{20};
+
+    /**
+     * @brief Create a servo output which starts in a restored position without moving.
+     * A servo without a known position outputs no pulse until it is moved the first time.
+     * @param config the configuration of the channel
+     * @param restored the last commanded position of the servo
+     */
+    explicit ServoOutputChannel(const config::ConfigGpio &config, const config::ServoPosition &restored = {});
     ~ServoOutputChannel();
 
     static void initLedc();
 
-    void initChannel() const;
-
     void setPendingAction(const config::SwitchAction &dir) { pendingAction_ = dir; }
     void removePendingAction() { pendingAction_.reset(); }
     [[nodiscard]] std::optional<config::SwitchAction> getPendingAction() const { return pendingAction_; }
     void executePendingAction();
 
     void checkOverdraw();
+    /**
+     * @brief End the overdraw early since the sense input reported the turnout in position.
+     * @param reason the event of the sense input
+     * @return false if the servo wasn't overdrawing
+     */
+    bool settle(SettleReason reason);
+    /**
+     * @brief Advance the current ramp.
+     * @param now the current time
+     * @return true if the servo is still ramping
+     */
+    bool stepMotion(std::chrono::steady_clock::time_point now);
+
+    [[nodiscard]] bool isMoving() const { return ramp_.has_value(); }
 
     [[nodiscard]] config::SwitchDirection getDirection() const { return currDir_; }
     [[nodiscard]] int getCurrPos() const { return currPos_; }
+    /**
+     * @brief Get the position the servo rests in after the current move.
+     */
+    [[nodiscard]] config::ServoPosition getPosition() const {
+        return {currDir_, currDir_ == config::SwitchDirection::eCustom ? customTime_ : 0};
+    }
     [[nodiscard]] bool isOverdrawing() const { return overdraw_; }
+    [[nodiscard]] bool hasSense() const { return config_.servoCfg_->sense != config::SenseMode::eNone; }
+    /**
+     * @brief Get the reading of a position sense input in the current direction in mV.
+     */
+    [[nodiscard]] int getSenseTarget() const;
+    /**
+     * @brief Get the measured time from the start of the last move until its overdraw ended.
+     */
+    [[nodiscard]] std::optional<std::chrono::steady_clock::duration> getLastMoveDuration() const {
+        return lastMoveDuration_;
+    }
+    [[nodiscard]] SettleReason getLastSettle() const { return lastSettle_; }
+    [[nodiscard]] uint32_t getStallCount() const { return stalls_; }
+    [[nodiscard]] std::chrono::steady_clock::time_point getOverdrawReleaseTime() const;
+    /**
+     * @brief Get the time the servo needs to finish the current move, including ramp and overdraw.
+     */
+    [[nodiscard]] std::chrono::steady_clock::duration getMoveDuration() const;
+    [[nodiscard]] const config::ConfigGpio &getConfig() const { return config_; }
+    [[nodiscard]] ServoStatus getStatus() const;
 
    private:
+    struct Ramp {
+        int from;
+        int to;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration length;
+    };
+
+    void initChannel(const config::ServoPosition &restored);
     void actionLeft();
     void actionRight();
+    void releaseOverdraw(SettleReason reason);
 
-    void setServo(int ms);
+    /**
+     * @brief Move the servo to a new position, either directly or along the configured motion profile.
+     * @return the time the servo reaches the position
+     */
+    std::chrono::steady_clock::time_point moveTo(int us);
+    void setServo(int us);
+    void writeDuty(int us);
 
     const config::ConfigGpio config_;
+    const ledc_channel_t ledcChannel_;
     std::chrono::steady_clock::time_point overdrawTime_{};
 
+    std::optional<Ramp> ramp_{};
+    std::chrono::steady_clock::duration rampLength_{};
+
     std::optional<config::SwitchAction> pendingAction_{};
     config::SwitchDirection currDir_{config::SwitchDirection::eUnknown};
     bool overdraw_{false};
     int currPos_{0};
+    int customTime_{0};
+
+    std::chrono::steady_clock::time_point moveStartedAt_{};
+    std::optional<std::chrono::steady_clock::duration> lastMoveDuration_{};
+    SettleReason lastSettle_{SettleReason::eNone};
+    uint32_t stalls_{0};
 };
 
+/**
+ * @brief All servo outputs, indexed by their channel.
+ */
+using ServoChannelTable = std::array<std::optional<ServoOutputChannel>, config::kChannelCount>;
+
 void to_json(nlohmann::json &j, const ServoOutputChannel &ch);
 }  // namespace io
 
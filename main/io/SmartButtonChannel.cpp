@@ -20,84 +20,67 @@
 
 #include "SmartButtonChannel.h"
 
-#include <driver/gpio.h>
 #include <esp_log.h>
-#include <freertos/FreeRTOS.h>
+
+#include "hal/Io.h"
 
 namespace io {
 SmartButtonChannel::SmartButtonChannel(const config::ConfigGpio &config) : config_(config) {
-    gpio_reset_pin(config_.gpio());
+    hal::gpio().reset(config_.gpio());
 }
 
 SmartButtonChannel::~SmartButtonChannel() = default;
 
-void SmartButtonChannel::setButton(bool val) {
-    gpio_set_level(config_.gpio(), (config_.buttonCfg_->invertedOutput && val) ? 0 : 1);
-}
-
-static bool currentBlinkState() {
-    auto now = std::chrono::steady_clock::now();
-    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-    return (millis % 1000) > 500;
-}
-
-bool SmartButtonChannel::tickButton() {
-    // Check the state of the button:
-    gpio_set_level(config_.gpio(), 0);
-    gpio_set_direction(config_.gpio(), GPIO_MODE_INPUT);
-
-    vTaskDelay(1 / portTICK_PERIOD_MS);
-    if (gpio_get_level(config_.gpio()) ^ config_.buttonCfg_->invertedInput) {
-        tickPressed_++;
-    } else {
-        tickPressed_ = 0;
+MatchingState SmartButtonChannel::evaluate(const config::SwitchAction &action,
+                                           const std::optional<ServoOutputChannel> &servo) {
+    // actions of remote or unconfigured servos don't affect the LED
+    if (!action.ip.empty() || !servo.has_value()) {
+        return MatchingState::eMatch;
     }
-
-    gpio_set_direction(config_.gpio(), GPIO_MODE_OUTPUT_OD);
-    if (matches_ == MatchingState::ePending) {
-        setButton(currentBlinkState());
-    } else if (matches_ == MatchingState::eMatch) {
-        setButton(true);
-    } else {
-        setButton(false);
+    auto pending = servo->getPendingAction();
+    if (pending.has_value()) {
+        return pending->direction == action.direction ? MatchingState::ePending : MatchingState::eNoMatch;
     }
-
-    return tickPressed_ == kRequiredTicks;
+    config::SwitchDirection current = servo->getDirection();
+    if (current != config::SwitchDirection::eUnknown && current != action.direction) {
+        return MatchingState::eNoMatch;
+    }
+    return MatchingState::eMatch;
 }
 
-void SmartButtonChannel::updateMatchingState(
-    const std::map<std::string, io::ServoOutputChannel> &channels) {
-    if (config_.buttonCfg_->actionOnPress.empty()) {
-        matches_ = MatchingState::eNoMatch;
-        return;
-    }
+void SmartButtonChannel::setActionState(size_t slot, MatchingState state) {
+    MatchingState &old = actionStates_[slot];
+    pendingCount_ += (state == MatchingState::ePending) - (old == MatchingState::ePending);
+    noMatchCount_ += (state == MatchingState::eNoMatch) - (old == MatchingState::eNoMatch);
+    old = state;
+}
 
-    int pendingCount = 0;
-    int noMatchesCount = 0;
-    for (const auto &item : config_.buttonCfg_->actionOnPress) {
-        auto ch = channels.find(item.channel);
-        if (ch == channels.end()) {
-            continue;
-        }
-        auto pending = ch->second.getPendingAction();
-        config::SwitchDirection current = ch->second.getDirection();
-        if (pending.has_value()) {
-            if (pending->direction == item.direction) {
-                pendingCount++;
-            } else {
-                noMatchesCount++;
-            }
-        } else if (current != config::SwitchDirection::eUnknown && current != item.direction) {
-            noMatchesCount++;
-        }
-    }
-    if (noMatchesCount > 0) {
+void SmartButtonChannel::refreshMatchingState() {
+    if (actionStates_.empty() || noMatchCount_ > 0) {
         matches_ = MatchingState::eNoMatch;
-    } else if (pendingCount > 0) {
+    } else if (pendingCount_ > 0) {
         matches_ = MatchingState::ePending;
     } else {
         matches_ = MatchingState::eMatch;
     }
 }
 
+void SmartButtonChannel::updateMatchingState(const ServoChannelTable &channels) {
+    const auto &actions = config_.buttonCfg_->actionOnPress;
+    actionStates_.assign(actions.size(), MatchingState::eMatch);
+    pendingCount_ = 0;
+    noMatchCount_ = 0;
+    for (size_t i = 0; i < actions.size(); i++) {
+        setActionState(i, evaluate(actions[i], channels[actions[i].channel]));
+    }
+    refreshMatchingState();
+}
+
+bool SmartButtonChannel::updateAction(size_t slot, const std::optional<ServoOutputChannel> &servo) {
+    setActionState(slot, evaluate(config_.buttonCfg_->actionOnPress[slot], servo));
+    MatchingState old = matches_;
+    refreshMatchingState();
+    return old != matches_;
+}
+
 }  // namespace io
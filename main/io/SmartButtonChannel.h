@@ -21,8 +21,9 @@
 #ifndef SWITCHCONTROL_IO_SMARTBUTTONCHANNEL_H
 #define SWITCHCONTROL_IO_SMARTBUTTONCHANNEL_H
 
-#include <deque>
-#include <map>
+#include <array>
+#include <optional>
+#include <vector>
 
 #include "ServoOutChannel.h"
 #include "config/ButtonConfig.h"
@@ -32,27 +33,49 @@
 namespace io {
 enum class MatchingState { eNoMatch = 0, eMatch = 1, ePending = 2 };
 
+/**
+ * @brief This class represents a single smart button channel.
+ * The button itself is sampled by the io::ButtonSampler, this class only tracks the state shown on its LED.
+ */
 class SmartButtonChannel {
    public:
-    const inline static int kRequiredTicks = 3;
-
     explicit SmartButtonChannel(const config::ConfigGpio &config);
     ~SmartButtonChannel();
 
-    [[nodiscard]] bool tickButton();
-
-    void updateMatchingState(const std::map<std::string, io::ServoOutputChannel> &channels);
+    /**
+     * @brief Recalculate the matching state from all actions.
+     * @param channels all servo channels
+     */
+    void updateMatchingState(const ServoChannelTable &channels);
+    /**
+     * @brief Update the matching state after the servo of a single action changed.
+     * @param slot index of the action in the list of actions on press
+     * @param servo the servo referenced by the action, nothing if it isn't configured
+     * @return true if the matching state changed
+     */
+    bool updateAction(size_t slot, const std::optional<ServoOutputChannel> &servo);
 
     [[nodiscard]] std::vector<config::SwitchAction> getAction() { return config_.buttonCfg_->actionOnPress; }
+    [[nodiscard]] MatchingState getMatchingState() const { return matches_; }
+    [[nodiscard]] const config::ConfigGpio &getConfig() const { return config_; }
 
    private:
     const config::ConfigGpio config_;
 
     MatchingState matches_{MatchingState::ePending};
-    int tickPressed_{0};
+    // state of each action, the counters are kept in sync to avoid rescanning all actions
+    std::vector<MatchingState> actionStates_;
+    int pendingCount_{0};
+    int noMatchCount_{0};
 
-    void setButton(bool val);
+    static MatchingState evaluate(const config::SwitchAction &action, const std::optional<ServoOutputChannel> &servo);
+    void setActionState(size_t slot, MatchingState state);
+    void refreshMatchingState();
 };
+/**
+ * @brief All smart buttons, indexed by their channel.
+ */
+using ButtonChannelTable = std::array<std::optional<SmartButtonChannel>, config::kChannelCount>;
 }  // namespace io
 
 #endif  // SWITCHCONTROL_IO_SMARTBUTTONCHANNEL_H
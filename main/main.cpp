@@ -18,36 +18,111 @@
  */
 
 #include <esp_log.h>
+#include <esp_random.h>
+#include <esp_system.h>
 #include <hal/efuse_hal.h>
 
+#include "config/PositionStore.h"
 #include "controller/OperationController.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "remote/PeerLink.h"
+#include "util/DeferredLog.h"
+#include "util/EventLog.h"
+#include "util/Metrics.h"
 #include "webserver/ConfigurationServer.h"
 #include "wifi/WiFiController.h"
 
+static void runController(void *arg) { static_cast<OperationController *>(arg)->run(); }
+
+static void runNotifier(void *arg) { static_cast<OperationController *>(arg)->runNotifier(); }
+
+static void runPeers(void *arg) { static_cast<remote::PeerLink *>(arg)->run(); }
+
+static void runPersistence(void *arg) { static_cast<config::PersistenceWorker *>(arg)->run(); }
+
+static void runLog(void *arg) { static_cast<util::DeferredLog *>(arg)->run(); }
+
+static void flushLog() { util::deferredLog().flush(); }
+
+// the positions are only written after a long idle period, an orderly restart writes them before
+static config::PersistenceWorker *restartPersistence = nullptr;
+
+static void flushConfig() {
+    if (restartPersistence != nullptr) {
+        restartPersistence->flush();
+    }
+}
+
 [[noreturn]] void start_main(void) {
+    // log lines are written by a low priority task from here on, no task waits for the UART
+    util::deferredLog().install();
+    esp_register_shutdown_handler(&flushLog);
+    xTaskCreatePinnedToCore(&runLog, "log", 3072, &util::deferredLog(), util::DeferredLog::kTaskPriority, nullptr,
+                            util::DeferredLog::kTaskCore);
     ESP_LOGI("Start", "Starting on Chip with rev %" PRIu32 ".%" PRIu32, efuse_hal_get_major_chip_version(),
              efuse_hal_get_minor_chip_version());
+    util::events().begin(static_cast<uint16_t>(esp_reset_reason()));
     config::ConfigurationStorage::setup();
     OperationController ctrl;
+    ctrl.setPowerConfig(config::readPower());
+    ctrl.setRoutes(config::readRoutes());
+
+    config::PersistenceWorker persistence;
+    xTaskCreatePinnedToCore(&runPersistence, "persist", 4096, &persistence, config::PersistenceWorker::kTaskPriority,
+                            nullptr, config::PersistenceWorker::kTaskCore);
+    restartPersistence = &persistence;
+    esp_register_shutdown_handler(&flushConfig);
+    config::ConfigurationStorage storage(persistence);
 
-    config::ConfigurationStorage storage;
+    // servos start in their last position, before any channel is added
+    config::PositionStore positions(persistence);
+    ctrl.restorePositions(positions.restore());
+    ctrl.setPositionListener([&positions](const config::ServoPositions &current) { positions.save(current); });
 
     config::WiFiConfig cfg = config::readWiFi();
-    wifi::WiFiController wifi(cfg);
-    httpserver::ConfigurationServer server(storage, wifi, ctrl);
+    wifi::WiFiController wifi(cfg, persistence);
+    httpserver::ConfigurationServer server(storage, persistence, wifi, ctrl);
     if (!server.start()) {
         esp_restart();
     }
 
     for (const auto &item : storage.getChannels()) {
-        ESP_LOGI("Start", "Initializing channel %s", item.channel.c_str());
-        ctrl.addNewChannel(item);
+        ESP_LOGI("Start", "Initializing channel %s", config::channelName(item.channel));
+        ctrl.updateChannel(item);
     }
 
+    remote::PeerLink peers(esp_random());
+    peers.setActionHandler([&ctrl](const std::vector<config::SwitchAction> &actions) {
+        try {
+            ctrl.requestSwitchChange(actions);
+            return true;
+        } catch (const std::invalid_argument &e) {
+            // interlocked by a route, a retransmit would be rejected as well
+            ESP_LOGW("Peer", "Rejecting actions of peer: %s", e.what());
+            return true;
+        } catch (const std::exception &e) {
+            ESP_LOGW("Peer", "Unable to apply actions of peer: %s", e.what());
+            return false;
+        }
+    });
+    ctrl.setRemoteSender([&peers](const std::string &peer, const std::vector<config::SwitchAction> &actions) {
+        peers.send(peer, actions);
+    });
+    if (peers.start()) {
+        xTaskCreatePinnedToCore(&runPeers, "peers", 4096, &peers, 4, nullptr, OperationController::kNetworkCore);
+    }
+
+    xTaskCreatePinnedToCore(&runNotifier, "notify", 4096, &ctrl, OperationController::kNotifierPriority, nullptr,
+                            OperationController::kNetworkCore);
+    xTaskCreatePinnedToCore(&runController, "control", 4096, &ctrl, OperationController::kTaskPriority, nullptr,
+                            OperationController::kTaskCore);
+
     while (true) {
-        ctrl.tick();
-        wifi.tick();
+        {
+            const util::Stopwatch stopwatch(util::metrics().wifiTick);
+            wifi.tick();
+        }
         vTaskDelay(20 / portTICK_PERIOD_MS);
     }
 }
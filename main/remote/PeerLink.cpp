@@ -0,0 +1,265 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PeerLink.h"
+
+#include <arpa/inet.h>
+#include <esp_log.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+namespace remote {
+static const char *kTag = "Peer";
+
+static bool sameAddress(const sockaddr_in &a, const sockaddr_in &b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+PeerLink::PeerLink(uint32_t session, uint16_t port) : session_(session), port_(port) {}
+
+PeerLink::~PeerLink() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool PeerLink::start() {
+    fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd_ < 0) {
+        ESP_LOGE(kTag, "Unable to open peer socket");
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ESP_LOGE(kTag, "Unable to bind peer socket to port %u", port_);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+uint16_t PeerLink::localPort() const {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (fd_ < 0 || getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+std::optional<sockaddr_in> PeerLink::resolve(const std::string &peer) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPeerPort);
+
+    std::string host = peer;
+    if (auto colon = peer.find(':'); colon != std::string::npos) {
+        host = peer.substr(0, colon);
+        unsigned long port = std::strtoul(peer.c_str() + colon + 1, nullptr, 10);
+        if (port == 0 || port > UINT16_MAX) {
+            return std::nullopt;
+        }
+        addr.sin_port = htons(port);
+    }
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        return std::nullopt;
+    }
+    return addr;
+}
+
+void PeerLink::transmit(const sockaddr_in &addr, const std::vector<uint8_t> &payload) const {
+    if (sendto(fd_, payload.data(), payload.size(), 0, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+        ESP_LOGW(kTag, "Unable to send datagram to peer");
+    }
+}
+
+bool PeerLink::send(const std::string &peer, const std::vector<config::SwitchAction> &actions) {
+    if (fd_ < 0) {
+        return false;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(peer);
+    if (it == peers_.end()) {
+        auto addr = resolve(peer);
+        if (!addr.has_value()) {
+            ESP_LOGW(kTag, "Invalid peer address: %s", peer.c_str());
+            return false;
+        }
+        it = peers_.emplace(peer, Peer{*addr, 1, {}}).first;
+    }
+    Peer &p = it->second;
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < actions.size(); offset += kMaxPeerActions) {
+        PeerMessage msg{MessageType::eActions, session_, p.nextSequence++, {}};
+        size_t end = std::min(actions.size(), offset + kMaxPeerActions);
+        msg.actions.assign(actions.begin() + offset, actions.begin() + end);
+
+        if (p.unacked.size() >= kMaxUnacked) {
+            ESP_LOGW(kTag, "Peer %s doesn't respond, dropping datagram %lu", peer.c_str(),
+                     static_cast<unsigned long>(p.unacked.front().sequence));
+            p.unacked.pop_front();
+        }
+        Datagram &datagram = p.unacked.emplace_back(Datagram{msg.sequence, encodeMessage(msg), now, 1});
+        transmit(p.addr, datagram.payload);
+    }
+    return true;
+}
+
+static_assert(PeerLink::kReceiveWindow <= 64, "the receive window is a 64 bit mask");
+
+bool PeerLink::Sender::applied(uint32_t sequence) const {
+    if (sequence <= base) {
+        return true;
+    }
+    uint32_t offset = sequence - base - 1;
+    return offset < kReceiveWindow && (seen >> offset) & 1;
+}
+
+void PeerLink::Sender::markApplied(uint32_t sequence) {
+    if (sequence <= base) {
+        return;
+    }
+    if (sequence - base > kReceiveWindow) {
+        // the sender gave up on everything that falls out of the window
+        uint32_t shift = sequence - base - kReceiveWindow;
+        seen = shift >= kReceiveWindow ? 0 : seen >> shift;
+        base += shift;
+    }
+    seen |= uint64_t{1} << (sequence - base - 1);
+    // advance over the applied sequence numbers without a gap
+    while (seen & 1) {
+        seen >>= 1;
+        base++;
+    }
+}
+
+void PeerLink::receive(const uint8_t *data, size_t size, const sockaddr_in &from) {
+    auto msg = decodeMessage(data, size);
+    if (!msg.has_value()) {
+        ESP_LOGD(kTag, "Dropping malformed datagram");
+        return;
+    }
+
+    if (msg->type == MessageType::eAck) {
+        if (msg->session != session_) {
+            return;
+        }
+        const std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &[name, peer] : peers_) {
+            if (sameAddress(peer.addr, from)) {
+                std::erase_if(peer.unacked, [&](const Datagram &d) { return d.sequence == msg->sequence; });
+            }
+        }
+        return;
+    }
+
+    uint64_t key = (static_cast<uint64_t>(from.sin_addr.s_addr) << 16) | from.sin_port;
+    auto sender = senders_.find(key);
+    if (sender == senders_.end() || sender->second.session != msg->session) {
+        if (sender == senders_.end() && senders_.size() >= kMaxSenders) {
+            // any host can send datagrams, a retransmission of the forgotten sender would be applied again
+            senders_.erase(std::min_element(senders_.begin(), senders_.end(), [](const auto &a, const auto &b) {
+                return a.second.lastUse < b.second.lastUse;
+            }));
+        }
+        // a new session starts with sequence number 1
+        sender = senders_.insert_or_assign(key, Sender{msg->session, 0, 0}).first;
+    }
+    sender->second.lastUse = ++uses_;
+    if (!sender->second.applied(msg->sequence)) {
+        if (!handler_ || !handler_(msg->actions)) {
+            // not acknowledged, the peer retransmits it
+            return;
+        }
+        sender->second.markApplied(msg->sequence);
+    }
+    transmit(from, encodeMessage(PeerMessage{MessageType::eAck, msg->session, msg->sequence, {}}));
+}
+
+void PeerLink::retransmit(std::chrono::steady_clock::time_point now) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &[name, peer] : peers_) {
+        for (auto it = peer.unacked.begin(); it != peer.unacked.end();) {
+            if (now - it->sentAt < kRetransmitInterval) {
+                ++it;
+                continue;
+            }
+            if (it->attempts >= kMaxAttempts) {
+                ESP_LOGW(kTag, "Peer %s didn't acknowledge datagram %lu", name.c_str(),
+                         static_cast<unsigned long>(it->sequence));
+                it = peer.unacked.erase(it);
+                continue;
+            }
+            transmit(peer.addr, it->payload);
+            it->attempts++;
+            it->sentAt = now;
+            ++it;
+        }
+    }
+}
+
+void PeerLink::poll(std::chrono::milliseconds timeout) {
+    if (fd_ < 0) {
+        return;
+    }
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd_, &fds);
+    timeval tv{};
+    tv.tv_sec = timeout.count() / 1000;
+    tv.tv_usec = (timeout.count() % 1000) * 1000;
+    if (select(fd_ + 1, &fds, nullptr, nullptr, &tv) > 0) {
+        std::array<uint8_t, 512> buf{};
+        sockaddr_in from{};
+        socklen_t len = sizeof(from);
+        ssize_t n;
+        while ((n = recvfrom(fd_, buf.data(), buf.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&from), &len)) >
+               0) {
+            receive(buf.data(), n, from);
+            len = sizeof(from);
+        }
+    }
+    retransmit(std::chrono::steady_clock::now());
+}
+
+void PeerLink::run() {
+    while (true) {
+        poll(kRetransmitInterval / 4);
+    }
+}
+
+size_t PeerLink::unacked() {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto &[name, peer] : peers_) {
+        count += peer.unacked.size();
+    }
+    return count;
+}
+}  // namespace remote
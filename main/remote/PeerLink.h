@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_REMOTE_PEERLINK_H
+#define SWITCHCONTROL_REMOTE_PEERLINK_H
+
+#include <netinet/in.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "PeerProtocol.h"
+
+namespace remote {
+/**
+ * @brief Forwards switch actions to other boards over UDP and receives their actions.
+ * Each datagram carries a sequence number and is retransmitted until the peer acknowledges it. A peer applies each
+ * datagram once, in any order: it keeps a window of the applied sequence numbers per sender, retransmissions of an
+ * already applied datagram are only acknowledged again.
+ */
+class PeerLink {
+   public:
+    /**
+     * @brief Receives the actions sent by a peer.
+     * @return false if the actions couldn't be accepted, the peer retransmits them later
+     */
+    using ActionHandler = std::function<bool(const std::vector<config::SwitchAction> &)>;
+
+    static constexpr auto kRetransmitInterval = std::chrono::milliseconds(200);
+    static constexpr int kMaxAttempts = 5;
+    static constexpr size_t kMaxUnacked = 8;  ///< per peer, the oldest datagram is dropped when exceeded
+    static constexpr uint32_t kReceiveWindow = 64;  ///< sequence numbers further behind count as applied
+    static constexpr size_t kMaxSenders = 16;  ///< the sender heard least recently is forgotten when exceeded
+
+    /**
+     * @brief Create a new link, the socket is opened by start().
+     * @param session random id of this board, has to change with each boot
+     * @param port the local port, 0 picks a free port
+     */
+    explicit PeerLink(uint32_t session, uint16_t port = kPeerPort);
+    ~PeerLink();
+    PeerLink(const PeerLink &) = delete;
+    PeerLink &operator=(const PeerLink &) = delete;
+
+    /**
+     * @brief Open and bind the socket.
+     * @return false if the socket couldn't be opened
+     */
+    bool start();
+    [[nodiscard]] uint16_t localPort() const;
+
+    /**
+     * @brief Set the handler for received actions. Has to be set before start() is called.
+     */
+    void setActionHandler(ActionHandler handler) { handler_ = std::move(handler); }
+
+    /**
+     * @brief Send actions to a peer in a single datagram. May be called from any task.
+     * @param peer address of the peer, "ip" or "ip:port"
+     * @param actions the actions, the ip of the actions is ignored
+     * @return false if the address is invalid or the link isn't started
+     */
+    bool send(const std::string &peer, const std::vector<config::SwitchAction> &actions);
+
+    /**
+     * @brief Receive datagrams for up to the given time and retransmit unacknowledged datagrams.
+     */
+    void poll(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Poll the link in the calling task.
+     */
+    [[noreturn]] void run();
+
+    /**
+     * @brief Get the number of datagrams which weren't acknowledged yet.
+     */
+    [[nodiscard]] size_t unacked();
+
+   private:
+    struct Datagram {
+        uint32_t sequence;
+        std::vector<uint8_t> payload;
+        std::chrono::steady_clock::time_point sentAt;
+        int attempts;
+    };
+    struct Peer {
+        sockaddr_in addr;
+        uint32_t nextSequence{1};
+        std::deque<Datagram> unacked;
+    };
+    /**
+     * @brief Receive window of a sender, all sequence numbers up to base are applied, bit i of seen is base + 1 + i.
+     */
+    struct Sender {
+        uint32_t session;
+        uint32_t base;
+        uint64_t seen;
+        uint32_t lastUse{0};
+
+        [[nodiscard]] bool applied(uint32_t sequence) const;
+        void markApplied(uint32_t sequence);
+    };
+
+    static std::optional<sockaddr_in> resolve(const std::string &peer);
+    void transmit(const sockaddr_in &addr, const std::vector<uint8_t> &payload) const;
+    void receive(const uint8_t *data, size_t size, const sockaddr_in &from);
+    void retransmit(std::chrono::steady_clock::time_point now);
+
+    const uint32_t session_;
+    const uint16_t port_;
+    int fd_{-1};
+    ActionHandler handler_;
+
+    std::mutex mutex_;
+    std::map<std::string, Peer> peers_;  // guarded by mutex_, indexed by the address as configured
+    std::map<uint64_t, Sender> senders_;  // only used by the polling task, indexed by address and port
+    uint32_t uses_{0};  // counts the received datagrams to find the sender heard least recently
+};
+}  // namespace remote
+
+#endif  // SWITCHCONTROL_REMOTE_PEERLINK_H
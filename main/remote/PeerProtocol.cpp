@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PeerProtocol.h"
+
+#include <stdexcept>
+
+#include "util/ByteBuffer.h"
+
+namespace remote {
+static const inline uint16_t kMagic = 0x4353;  // "SC"
+static const inline uint8_t kVersion = 1;
+
+std::vector<uint8_t> encodeMessage(const PeerMessage &msg) {
+    if (msg.actions.size() > kMaxPeerActions) {
+        throw std::invalid_argument("Too many actions for a single peer: " + std::to_string(msg.actions.size()));
+    }
+    std::vector<uint8_t> data;
+    data.reserve(13 + msg.actions.size() * 4);
+    util::ByteWriter w(data);
+    w.u16(kMagic);
+    w.u8(kVersion);
+    w.u8(static_cast<uint8_t>(msg.type));
+    w.u32(msg.session);
+    w.u32(msg.sequence);
+    if (msg.type == MessageType::eActions) {
+        w.u8(msg.actions.size());
+        for (const auto &action : msg.actions) {
+            w.u8(action.channel);
+            w.u8(static_cast<uint8_t>(action.direction));
+            w.u16(action.customTime);
+        }
+    }
+    return data;
+}
+
+std::optional<PeerMessage> decodeMessage(const uint8_t *data, size_t size) {
+    try {
+        util::ByteReader r(data, size);
+        if (r.u16() != kMagic || r.u8() != kVersion) {
+            return std::nullopt;
+        }
+        PeerMessage msg{};
+        msg.type = static_cast<MessageType>(r.u8());
+        msg.session = r.u32();
+        msg.sequence = r.u32();
+        if (msg.type == MessageType::eActions) {
+            size_t count = r.u8();
+            if (count > kMaxPeerActions) {
+                return std::nullopt;
+            }
+            for (size_t i = 0; i < count; i++) {
+                config::SwitchAction action{};
+                action.channel = r.u8();
+                action.direction = static_cast<config::SwitchDirection>(static_cast<int8_t>(r.u8()));
+                action.customTime = r.u16();
+                action.validate();
+                msg.actions.push_back(std::move(action));
+            }
+        } else if (msg.type != MessageType::eAck) {
+            return std::nullopt;
+        }
+        if (!r.done()) {
+            return std::nullopt;
+        }
+        return msg;
+    } catch (const std::exception &e) {
+        return std::nullopt;
+    }
+}
+}  // namespace remote
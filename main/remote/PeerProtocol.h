@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_REMOTE_PEERPROTOCOL_H
+#define SWITCHCONTROL_REMOTE_PEERPROTOCOL_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "config/ServoConfig.h"
+
+namespace remote {
+constexpr inline uint16_t kPeerPort = 3620;
+constexpr inline size_t kMaxPeerActions = 64;
+
+enum class MessageType : uint8_t { eActions = 1, eAck = 2 };
+
+/**
+ * @brief A datagram exchanged between two boards.
+ * All actions of a request bound for one peer travel in a single datagram, the peer acknowledges it with the same
+ * sequence number.
+ */
+struct PeerMessage {
+    MessageType type{MessageType::eActions};
+    uint32_t session{0};   ///< random id of the sending board, changes with each boot
+    uint32_t sequence{0};  ///< increasing number per session and peer
+    std::vector<config::SwitchAction> actions;  ///< actions for the servos of the peer, empty for acks
+};
+
+/**
+ * @brief Encode a message into a datagram.
+ * @throws std::invalid_argument if the message holds more than kMaxPeerActions actions
+ */
+std::vector<uint8_t> encodeMessage(const PeerMessage &msg);
+
+/**
+ * @brief Decode a datagram.
+ * @return the message or nothing if the datagram is malformed or contains invalid actions
+ */
+std::optional<PeerMessage> decodeMessage(const uint8_t *data, size_t size);
+}  // namespace remote
+
+#endif  // SWITCHCONTROL_REMOTE_PEERPROTOCOL_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_BYTEBUFFER_H
+#define SWITCHCONTROL_UTIL_BYTEBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace util {
+/**
+ * @brief Appends little endian values to a buffer.
+ */
+class ByteWriter {
+   public:
+    explicit ByteWriter(std::vector<uint8_t> &buf) : buf_(buf) {}
+
+    void u8(uint8_t v) { buf_.push_back(v); }
+    void u16(uint16_t v) {
+        u8(v & 0xFF);
+        u8(v >> 8);
+    }
+    void u32(uint32_t v) {
+        u16(v & 0xFFFF);
+        u16(v >> 16);
+    }
+    void str(const std::string &s) {
+        if (s.size() > UINT8_MAX) {
+            throw std::runtime_error("String too long to store: " + s);
+        }
+        u8(s.size());
+        buf_.insert(buf_.end(), s.begin(), s.end());
+    }
+
+   private:
+    std::vector<uint8_t> &buf_;
+};
+
+/**
+ * @brief Reads little endian values from a buffer.
+ * @throws std::runtime_error when reading past the end
+ */
+class ByteReader {
+   public:
+    ByteReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t u8() {
+        need(1);
+        return data_[pos_++];
+    }
+    uint16_t u16() {
+        uint16_t lo = u8();
+        return lo | (u8() << 8);
+    }
+    uint32_t u32() {
+        uint32_t lo = u16();
+        return lo | (static_cast<uint32_t>(u16()) << 16);
+    }
+    std::string str() {
+        size_t len = u8();
+        need(len);
+        std::string s(reinterpret_cast<const char *>(data_ + pos_), len);
+        pos_ += len;
+        return s;
+    }
+    [[nodiscard]] bool done() const { return pos_ == size_; }
+
+   private:
+    void need(size_t n) const {
+        if (size_ - pos_ < n) {
+            throw std::runtime_error("buffer truncated");
+        }
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t pos_{0};
+};
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_BYTEBUFFER_H
@@ -0,0 +1,181 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "DeferredLog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace util {
+
+static const std::array<std::pair<esp_log_level_t, const char *>, 6> kLevelNames = {{
+    {ESP_LOG_NONE, "None"},
+    {ESP_LOG_ERROR, "Error"},
+    {ESP_LOG_WARN, "Warn"},
+    {ESP_LOG_INFO, "Info"},
+    {ESP_LOG_DEBUG, "Debug"},
+    {ESP_LOG_VERBOSE, "Verbose"},
+}};
+
+const char *logLevelName(esp_log_level_t level) {
+    for (const auto &[value, name] : kLevelNames) {
+        if (value == level) {
+            return name;
+        }
+    }
+    return "Invalid";
+}
+
+std::optional<esp_log_level_t> logLevelFromName(const std::string &name) {
+    for (const auto &[value, levelName] : kLevelNames) {
+        if (name == levelName) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+DeferredLog &deferredLog() {
+    static DeferredLog instance;
+    return instance;
+}
+
+void DeferredLog::install() {
+    if (output_ == nullptr) {
+        output_ = esp_log_set_vprintf(&DeferredLog::vprintf);
+    }
+}
+
+int DeferredLog::vprintf(const char *format, va_list args) { return deferredLog().write(format, args); }
+
+int DeferredLog::write(const char *format, va_list args) {
+    Line line;
+    int length = vsnprintf(line.text.data(), line.text.size(), format, args);
+    if (length < 0) {
+        return length;
+    }
+    if (static_cast<size_t>(length) >= line.text.size()) {
+        truncated_.fetch_add(1, std::memory_order_relaxed);
+        line.length = static_cast<uint16_t>(line.text.size() - 1);
+        line.text[line.length - 1] = '\n';
+    } else {
+        line.length = static_cast<uint16_t>(length);
+    }
+    if (!queue_.push(std::move(line))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return length;
+    }
+    TaskHandle_t task = task_.load();
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    }
+    return length;
+}
+
+/**
+ * @brief Write a line with the original output of the log library.
+ */
+static int printLine(vprintf_like_t output, const char *format, ...) {
+    if (output == nullptr) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int result = output(format, args);
+    va_end(args);
+    return result;
+}
+
+void DeferredLog::print(const Line &line) {
+    printLine(output_, "%.*s", static_cast<int>(line.length), line.text.data());
+    const std::lock_guard<std::mutex> lock(mutex_);
+    history_[written_ % kHistorySize] = line;
+    written_++;
+}
+
+void DeferredLog::flush() {
+    // the queue has a single consumer, a restart may flush while the drain task is running
+    const std::lock_guard<std::mutex> lock(flushMutex_);
+    Line line;
+    while (queue_.pop(line)) {
+        print(line);
+    }
+    uint32_t drops = dropped();
+    if (drops != reportedDrops_) {
+        printLine(output_, "W log: %lu lines dropped\n", static_cast<unsigned long>(drops - reportedDrops_));
+        reportedDrops_ = drops;
+    }
+}
+
+void DeferredLog::run() {
+    task_ = xTaskGetCurrentTaskHandle();
+    while (true) {
+        flush();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void DeferredLog::setLevel(const std::string &tag, esp_log_level_t level) {
+    if (level > CONFIG_LOG_MAXIMUM_LEVEL) {
+        // the log macros drop more verbose calls at compile time, the level would never take effect
+        throw std::invalid_argument(std::string("Log level is above the maximum of this build: ") +
+                                    logLevelName(static_cast<esp_log_level_t>(CONFIG_LOG_MAXIMUM_LEVEL)));
+    }
+    esp_log_level_set(tag.c_str(), level);
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (tag == "*") {
+        // the default replaces all levels of single tags
+        levels_.clear();
+    }
+    levels_[tag] = level;
+}
+
+void DeferredLog::writeStatus(JsonWriter &w, uint32_t since) {
+    // copied first, the drain task must not wait for the client
+    std::map<std::string, esp_log_level_t> levels;
+    std::vector<std::string> lines;
+    uint32_t next;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        levels = levels_;
+        next = written_;
+        // only the latest lines are kept
+        uint32_t first = written_ > kHistorySize ? written_ - kHistorySize : 0;
+        for (uint32_t i = std::max(since, first); i < written_; i++) {
+            const Line &line = history_[i % kHistorySize];
+            lines.emplace_back(line.text.data(), line.length);
+        }
+    }
+
+    w.beginObject();
+    w.field("maximum", logLevelName(static_cast<esp_log_level_t>(CONFIG_LOG_MAXIMUM_LEVEL)));
+    w.field("dropped", dropped());
+    w.field("truncated", truncated());
+    w.key("levels").beginObject();
+    for (const auto &[tag, level] : levels) {
+        w.field(tag, logLevelName(level));
+    }
+    w.endObject();
+    w.field("next", next);
+    w.field("lines", lines);
+    w.endObject();
+}
+}  // namespace util
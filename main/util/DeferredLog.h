@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_DEFERREDLOG_H
+#define SWITCHCONTROL_UTIL_DEFERREDLOG_H
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "JsonWriter.h"
+#include "MpscQueue.h"
+
+namespace util {
+
+const char *logLevelName(esp_log_level_t level);
+std::optional<esp_log_level_t> logLevelFromName(const std::string &name);
+
+/**
+ * @brief Moves the output of ESP_LOG off the calling task.
+ * Installed as vprintf of the log library, a log call only formats its line into a queue, a low priority task writes
+ * the lines to the UART. Lines are formatted right away since their arguments, e.g. strings of the caller, don't
+ * outlive the call. Lines are dropped if the queue is full and cut at kLineLength, both are counted. The latest lines
+ * are kept for the http log endpoint.
+ * An orderly restart has to flush() from a shutdown handler. A panic does not run these handlers, up to kQueueSize
+ * lines logged right before a crash are lost, the panic handler itself writes to the UART directly.
+ */
+class DeferredLog {
+   public:
+    static constexpr size_t kLineLength = 160;
+    static constexpr size_t kQueueSize = 32;
+    static constexpr size_t kHistorySize = 32;
+    const inline static int kTaskPriority = 1;
+    const inline static BaseType_t kTaskCore = 0;
+
+    struct Line {
+        uint16_t length{0};
+        std::array<char, kLineLength> text{};
+    };
+
+    /**
+     * @brief Route all log output through the queue, lines logged before run() is started are kept in the queue.
+     */
+    void install();
+
+    /**
+     * @brief Write the queued lines in the calling task, it sleeps until new lines are logged.
+     */
+    [[noreturn]] void run();
+
+    /**
+     * @brief Format a line into the queue, the vprintf of the log library.
+     * @return the length of the formatted line or a negative value on an error
+     */
+    int write(const char *format, va_list args);
+
+    /**
+     * @brief Write all queued lines and the number of lines dropped since the last flush.
+     */
+    void flush();
+
+    /**
+     * @brief Set the level of a tag at runtime, "*" sets the default of all tags.
+     * @throws std::invalid_argument if the level is above CONFIG_LOG_MAXIMUM_LEVEL, such calls are compiled out
+     */
+    void setLevel(const std::string &tag, esp_log_level_t level);
+
+    [[nodiscard]] uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t truncated() const { return truncated_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Write the counters, the levels set at runtime and the kept lines newer than since.
+     * @param w the writer
+     * @param since the number of the first line to write
+     */
+    void writeStatus(JsonWriter &w, uint32_t since);
+
+   private:
+    MpscQueue<Line, kQueueSize> queue_;
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> truncated_{0};
+    std::atomic<TaskHandle_t> task_{nullptr};
+    vprintf_like_t output_{nullptr};
+
+    // held by the task writing the queue, the drain task or a restarting task
+    std::mutex flushMutex_;
+    uint32_t reportedDrops_{0};
+
+    // written by the drain task, read by the http server
+    std::mutex mutex_;
+    std::array<Line, kHistorySize> history_{};
+    uint32_t written_{0};
+    std::map<std::string, esp_log_level_t> levels_;
+
+    static int vprintf(const char *format, va_list args);
+    void print(const Line &line);
+};
+
+/**
+ * @brief The deferred log of this board.
+ */
+DeferredLog &deferredLog();
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_DEFERREDLOG_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "EventLog.h"
+
+#include <esp_attr.h>
+
+#include <atomic>
+
+#include "Metrics.h"
+
+namespace util {
+static const inline uint32_t kEventLogMagic = 0x45564c31;
+// marks a record which is being written
+static const inline uint32_t kWriting = UINT32_MAX;
+
+__NOINIT_ATTR static EventLog instance;
+
+EventLog &events() { return instance; }
+
+void EventLog::begin(uint16_t resetReason) {
+    bool valid = magic_ == kEventLogMagic;
+    for (size_t i = 0; valid && i < kCapacity; i++) {
+        // a record interrupted by the reset or overwritten by random content
+        uint32_t seq = records_[i].seq;
+        valid = seq == kWriting || seq % kCapacity == i;
+    }
+    if (!valid) {
+        for (auto &r : records_) {
+            r = EventRecord{kWriting, EventType::eBoot, kNoChannel, 0, 0};
+        }
+        head_ = 0;
+        magic_ = kEventLogMagic;
+    }
+    record(EventType::eBoot, kNoChannel, resetReason);
+}
+
+void EventLog::record(EventType type, uint8_t channel, uint16_t arg) {
+    uint32_t seq = std::atomic_ref<uint32_t>(head_).fetch_add(1, std::memory_order_relaxed);
+    if (seq == kWriting) {
+        // skip the marker, the ring stays consistent since kCapacity divides 2^32
+        seq = std::atomic_ref<uint32_t>(head_).fetch_add(1, std::memory_order_relaxed);
+    }
+    EventRecord &r = records_[seq % kCapacity];
+    std::atomic_ref<uint32_t> guard(r.seq);
+    guard.store(kWriting, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    r.type = type;
+    r.channel = channel;
+    r.arg = arg;
+    r.time = metricsNow();
+    guard.store(seq, std::memory_order_release);
+}
+
+size_t EventLog::read(uint32_t since, EventRecord *out, size_t max) {
+    uint32_t head = next();
+    // only the last kCapacity events can still be in the ring, this includes a since from before a power cycle
+    if (head - since > kCapacity) {
+        since = head >= kCapacity ? head - kCapacity : 0;
+    }
+    size_t count = 0;
+    for (uint32_t seq = since; seq != head && count < max; seq++) {
+        if (seq == kWriting) {
+            continue;
+        }
+        EventRecord &r = records_[seq % kCapacity];
+        std::atomic_ref<uint32_t> guard(r.seq);
+        uint32_t current = guard.load(std::memory_order_acquire);
+        if (current == kWriting || static_cast<int32_t>(seq - current) > 0) {
+            // not published yet
+            break;
+        }
+        if (current != seq) {
+            // already overwritten
+            continue;
+        }
+        EventRecord copy{seq, r.type, r.channel, r.arg, r.time};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // the writer of a newer event may have started meanwhile
+        if (guard.load(std::memory_order_relaxed) != seq) {
+            continue;
+        }
+        out[count++] = copy;
+    }
+    return count;
+}
+
+uint32_t EventLog::next() { return std::atomic_ref<uint32_t>(head_).load(std::memory_order_relaxed); }
+}  // namespace util
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_EVENTLOG_H
+#define SWITCHCONTROL_UTIL_EVENTLOG_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+/**
+ * @brief Type of a recorded event, the meaning of the argument depends on the type.
+ */
+enum class EventType : uint8_t {
+    eBoot = 0,            ///< arg: reset reason
+    eButtonPress = 1,     ///< debounced press handled by the controller
+    eQueued = 2,          ///< arg: direction | priority << 8
+    eMoveStarted = 3,     ///< arg: direction
+    eOverdrawEnd = 4,     ///< arg: io::SettleReason
+    eChannelConfig = 5,   ///< arg: config::ChannelType
+    eConfigChange = 6,    ///< arg: config::Document
+    eWiFiMode = 7,        ///< arg: config::WiFiMode
+    eWiFiState = 8,       ///< arg: state of the station connection
+};
+
+constexpr inline uint8_t kNoChannel = 0xff;
+
+/**
+ * @brief A single event, written to /api/events as is in little endian.
+ */
+struct EventRecord {
+    uint32_t seq;
+    EventType type;
+    uint8_t channel;  ///< kNoChannel for events of the board
+    uint16_t arg;
+    int64_t time;  ///< us since the boot the event was recorded in
+};
+
+static_assert(sizeof(EventRecord) == 16);
+
+/**
+ * @brief Ring buffer of the latest events. Recording is lock-free and cheap enough to stay on the hot paths, any task
+ * on either core may record. The ring lives in memory which is not cleared by a soft reset, so the events leading to
+ * a crash or restart can be read after it.
+ */
+class EventLog {
+   public:
+    static constexpr size_t kCapacity = 512;
+
+    /**
+     * @brief Keep the events of the previous boot if they survived the reset, otherwise clear the ring. Records the
+     * boot. Has to be called once at startup before any task records.
+     * @param resetReason the reason of the last reset
+     */
+    void begin(uint16_t resetReason);
+
+    void record(EventType type, uint8_t channel = kNoChannel, uint16_t arg = 0);
+
+    /**
+     * @brief Copy events in order of their sequence number. Stops at an event which is still being written, so a
+     * reader continuing after the last copied event doesn't miss it.
+     * @param since the first sequence number to copy, events which are no longer in the ring are skipped
+     * @param out receives the events
+     * @param max the maximum number of events to copy
+     * @return the number of copied events
+     */
+    size_t read(uint32_t since, EventRecord *out, size_t max);
+
+    /**
+     * @brief Get the sequence number of the next event.
+     */
+    [[nodiscard]] uint32_t next();
+
+   private:
+    // no member initializers, the log is placed in memory which is not initialized at startup
+    uint32_t magic_;
+    uint32_t head_;
+    std::array<EventRecord, kCapacity> records_;
+};
+
+/**
+ * @brief The event log of this board.
+ */
+EventLog &events();
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_EVENTLOG_H
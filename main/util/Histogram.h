@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_HISTOGRAM_H
+#define SWITCHCONTROL_UTIL_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * @brief Log-linear histogram with a fixed set of buckets, e.g. for durations in us.
+ * Values below kSubBuckets have a bucket each, above that every power of two is split into kSubBuckets linear
+ * buckets, so a percentile is off by less than 1/kSubBuckets. Recording never allocates and is lock-free, any task
+ * may record and read at the same time; readers may see a recording only partially.
+ */
+class Histogram {
+   public:
+    static constexpr int kSubBits = 2;
+    static constexpr uint32_t kSubBuckets = 1 << kSubBits;
+    static constexpr size_t kBucketCount = (32 - kSubBits + 1) * kSubBuckets;
+
+    /**
+     * @brief Record a value, negative values count as zero and large ones are clamped.
+     */
+    void record(int64_t raw) {
+        auto value = static_cast<uint32_t>(raw < 0 ? 0 : (raw > UINT32_MAX ? UINT32_MAX : raw));
+        buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        uint32_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the upper bound of the bucket containing a percentile, never more than the maximum.
+     * @param p the percentile between 0 and 1
+     * @return the value or 0 if nothing was recorded
+     */
+    [[nodiscard]] uint32_t percentile(double p) const {
+        uint32_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint32_t>(p * total);
+        uint32_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                uint32_t upper = upperBound(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    /**
+     * @brief Get the bucket of a value.
+     */
+    static constexpr size_t bucketOf(uint32_t value) {
+        if (value < kSubBuckets) {
+            return value;
+        }
+        int shift = std::bit_width(value) - 1 - kSubBits;
+        return (shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+    }
+
+    /**
+     * @brief Get the largest value of a bucket.
+     */
+    static constexpr uint32_t upperBound(size_t bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+        uint64_t lower = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << shift;
+        return static_cast<uint32_t>(lower + (uint64_t{1} << shift) - 1);
+    }
+
+   private:
+    std::array<std::atomic<uint32_t>, kBucketCount> buckets_{};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> max_{0};
+};
+
+static_assert(Histogram::bucketOf(UINT32_MAX) == Histogram::kBucketCount - 1 &&
+              Histogram::upperBound(Histogram::kBucketCount - 1) == UINT32_MAX);
+static_assert(Histogram::upperBound(Histogram::bucketOf(1000)) >= 1000 &&
+              Histogram::upperBound(Histogram::bucketOf(1000)) < 1250);
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_HISTOGRAM_H
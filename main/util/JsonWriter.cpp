@@ -0,0 +1,241 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "JsonWriter.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace util {
+
+bool JsonWriter::flush() {
+    if (len_ > 0 && !failed_) {
+        failed_ = !sink_(buf_.data(), len_);
+    }
+    len_ = 0;
+    return !failed_;
+}
+
+void JsonWriter::raw(char c) {
+    if (len_ == buf_.size()) {
+        flush();
+    }
+    buf_[len_++] = c;
+}
+
+void JsonWriter::raw(std::string_view data) {
+    while (!data.empty()) {
+        if (len_ == buf_.size()) {
+            flush();
+        }
+        size_t n = std::min(data.size(), buf_.size() - len_);
+        memcpy(buf_.data() + len_, data.data(), n);
+        len_ += n;
+        data.remove_prefix(n);
+    }
+}
+
+void JsonWriter::separator() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (depth_ > 0 && depth_ <= kMaxDepth) {
+        if (hasElement_[depth_ - 1]) {
+            raw(',');
+        }
+        hasElement_[depth_ - 1] = true;
+    }
+}
+
+void JsonWriter::push() {
+    if (depth_ >= kMaxDepth) {
+        // the document can't be completed, the sink doesn't get any further output
+        failed_ = true;
+    } else {
+        hasElement_[depth_] = false;
+    }
+    depth_++;
+}
+
+void JsonWriter::pop() {
+    if (depth_ > 0) {
+        depth_--;
+    }
+}
+
+JsonWriter &JsonWriter::beginObject() {
+    separator();
+    raw('{');
+    push();
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+    pop();
+    raw('}');
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+    separator();
+    raw('[');
+    push();
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+    pop();
+    raw(']');
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view name) {
+    separator();
+    string(name);
+    raw(':');
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::nullptr_t) {
+    separator();
+    raw("null");
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool v) {
+    separator();
+    raw(v ? "true" : "false");
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t v) {
+    separator();
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    raw(std::string_view(tmp, res.ptr - tmp));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(uint64_t v) {
+    separator();
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    raw(std::string_view(tmp, res.ptr - tmp));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(double v) {
+    separator();
+    if (!std::isfinite(v)) {
+        raw("null");
+        return *this;
+    }
+    char tmp[32];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    std::string_view num(tmp, res.ptr - tmp);
+    raw(num);
+    // keep the number a float like nlohmann does
+    if (num.find_first_of(".e") == std::string_view::npos) {
+        raw(".0");
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view v) {
+    separator();
+    string(v);
+    return *this;
+}
+
+void JsonWriter::string(std::string_view v) {
+    static const char *kHex = "0123456789abcdef";
+    raw('"');
+    for (char c : v) {
+        switch (c) {
+            case '"':
+                raw("\\\"");
+                break;
+            case '\\':
+                raw("\\\\");
+                break;
+            case '\n':
+                raw("\\n");
+                break;
+            case '\r':
+                raw("\\r");
+                break;
+            case '\t':
+                raw("\\t");
+                break;
+            case '\b':
+                raw("\\b");
+                break;
+            case '\f':
+                raw("\\f");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    raw("\\u00");
+                    raw(kHex[(c >> 4) & 0xF]);
+                    raw(kHex[c & 0xF]);
+                } else {
+                    raw(c);
+                }
+                break;
+        }
+    }
+    raw('"');
+}
+
+JsonWriter &JsonWriter::value(const nlohmann::json &j) {
+    switch (j.type()) {
+        case nlohmann::json::value_t::object:
+            beginObject();
+            for (const auto &item : j.items()) {
+                key(item.key());
+                value(item.value());
+            }
+            return endObject();
+        case nlohmann::json::value_t::array:
+            beginArray();
+            for (const auto &item : j) {
+                value(item);
+            }
+            return endArray();
+        case nlohmann::json::value_t::string:
+            return value(std::string_view(j.get_ref<const std::string &>()));
+        case nlohmann::json::value_t::boolean:
+            return value(j.get<bool>());
+        case nlohmann::json::value_t::number_integer:
+            return value(j.get<int64_t>());
+        case nlohmann::json::value_t::number_unsigned:
+            return value(j.get<uint64_t>());
+        case nlohmann::json::value_t::number_float:
+            return value(j.get<double>());
+        case nlohmann::json::value_t::null:
+        case nlohmann::json::value_t::binary:
+        case nlohmann::json::value_t::discarded:
+        default:
+            return value(nullptr);
+    }
+}
+}  // namespace util
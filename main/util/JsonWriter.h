@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_JSONWRITER_H
+#define SWITCHCONTROL_UTIL_JSONWRITER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Streaming json serializer writing through a small fixed buffer.
+ * Types provide a free function write_json(JsonWriter &, const T &) found by ADL, all other types are converted with
+ * their nlohmann to_json. Peak memory is the buffer instead of a json tree and a string of the whole document.
+ * Nesting is limited to kMaxDepth levels, a deeper document fails the writer like a failing sink.
+ */
+class JsonWriter {
+   public:
+    /**
+     * @brief Receives the serialized data whenever the buffer is full.
+     * @return false to abort, all further output is dropped
+     */
+    using Sink = std::function<bool(const char *data, size_t len)>;
+
+    static constexpr size_t kBufferSize = 512;
+    static constexpr size_t kMaxDepth = 32;
+
+    explicit JsonWriter(Sink sink) : sink_(std::move(sink)) {}
+
+    JsonWriter &beginObject();
+    JsonWriter &endObject();
+    JsonWriter &beginArray();
+    JsonWriter &endArray();
+    JsonWriter &key(std::string_view name);
+
+    JsonWriter &value(std::nullptr_t);
+    JsonWriter &value(bool v);
+    JsonWriter &value(int v) { return value(static_cast<int64_t>(v)); }
+    JsonWriter &value(unsigned int v) { return value(static_cast<uint64_t>(v)); }
+    JsonWriter &value(int64_t v);
+    JsonWriter &value(uint64_t v);
+    JsonWriter &value(double v);
+    JsonWriter &value(std::string_view v);
+    JsonWriter &value(const char *v) { return value(std::string_view(v)); }
+    JsonWriter &value(const std::string &v) { return value(std::string_view(v)); }
+    JsonWriter &value(const nlohmann::json &j);
+
+    template <typename T>
+    JsonWriter &value(const std::vector<T> &items) {
+        beginArray();
+        for (const auto &item : items) {
+            value(item);
+        }
+        return endArray();
+    }
+
+    template <typename T>
+    JsonWriter &value(const T &v) {
+        if constexpr (requires { write_json(*this, v); }) {
+            write_json(*this, v);
+            return *this;
+        } else {
+            return value(nlohmann::json(v));
+        }
+    }
+
+    template <typename T>
+    JsonWriter &field(std::string_view name, const T &v) {
+        key(name);
+        return value(v);
+    }
+
+    /**
+     * @brief Pass all buffered data to the sink.
+     * @return false if the sink failed at any time
+     */
+    bool flush();
+
+   private:
+    void separator();
+    /**
+     * @brief Enter a nesting level, nesting deeper than kMaxDepth fails the writer.
+     */
+    void push();
+    void pop();
+    void raw(std::string_view data);
+    void raw(char c);
+    void string(std::string_view v);
+
+    Sink sink_;
+    std::array<char, kBufferSize> buf_{};
+    size_t len_{0};
+    bool failed_{false};
+
+    // per nesting level whether an element was already written
+    std::array<bool, kMaxDepth> hasElement_{};
+    size_t depth_{0};
+    bool afterKey_{false};
+};
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_JSONWRITER_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Metrics.h"
+
+namespace util {
+
+Metrics &metrics() {
+    static Metrics instance;
+    return instance;
+}
+
+void write_json(JsonWriter &w, const Histogram &h) {
+    w.beginObject();
+    w.field("count", h.count());
+    w.field("p50", h.percentile(0.5));
+    w.field("p99", h.percentile(0.99));
+    w.field("max", h.max());
+    w.endObject();
+}
+
+void write_json(JsonWriter &w, const Metrics &m) {
+    w.beginObject();
+    w.field("control_tick_us", m.controlTick);
+    w.field("wifi_tick_us", m.wifiTick);
+    w.field("loop_jitter_us", m.loopJitter);
+    w.field("deadline_lateness_us", m.deadlineLateness);
+    w.field("command_queue_depth", m.commandQueueDepth);
+    w.field("button_latency_us", m.buttonLatency);
+    w.field("pending_depth", m.pendingDepth);
+    w.key("pending_wait_us");
+    w.beginObject();
+    for (size_t i = 0; i < kPriorityCount; i++) {
+        w.field(priorityName(static_cast<Priority>(i)), m.pendingWait[i]);
+    }
+    w.endObject();
+    w.endObject();
+}
+}  // namespace util
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_METRICS_H
+#define SWITCHCONTROL_UTIL_METRICS_H
+
+#include <esp_timer.h>
+
+#include <array>
+#include <cstdint>
+
+#include "Histogram.h"
+#include "JsonWriter.h"
+#include "Priority.h"
+
+namespace util {
+
+/**
+ * @brief Always-on latency histograms of the hot paths, all durations in us.
+ */
+struct Metrics {
+    Histogram controlTick;        ///< duration of OperationController::tick()
+    Histogram wifiTick;           ///< duration of WiFiController::tick()
+    Histogram loopJitter;         ///< deviation of the button sampling period from its nominal period
+    Histogram deadlineLateness;   ///< delay between a controller deadline and its handling
+    Histogram commandQueueDepth;  ///< commands waiting when a tick starts, not a duration
+    Histogram buttonLatency;      ///< from a debounced button press to the start of the servo move
+    Histogram pendingDepth;       ///< pending servo actions when a tick starts, not a duration
+    /// time a servo action was pending, indexed by Priority
+    std::array<Histogram, kPriorityCount> pendingWait;
+};
+
+/**
+ * @brief The metrics of this board.
+ */
+Metrics &metrics();
+
+/**
+ * @brief Timestamp for metrics in us.
+ * The microsecond timer is used instead of the cycle counter since timestamps are compared across the tasks on both
+ * cores, whose cycle counters are not synchronized.
+ */
+inline int64_t metricsNow() { return esp_timer_get_time(); }
+
+/**
+ * @brief Records the time from its creation until it goes out of scope.
+ */
+class Stopwatch {
+   public:
+    explicit Stopwatch(Histogram &histogram) : histogram_(histogram), start_(metricsNow()) {}
+    ~Stopwatch() { histogram_.record(metricsNow() - start_); }
+    Stopwatch(const Stopwatch &) = delete;
+    Stopwatch &operator=(const Stopwatch &) = delete;
+
+   private:
+    Histogram &histogram_;
+    int64_t start_;
+};
+
+/**
+ * @brief Write the count, p50, p99 and max of a histogram.
+ */
+void write_json(JsonWriter &w, const Histogram &h);
+void write_json(JsonWriter &w, const Metrics &m);
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_METRICS_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_MPSCQUEUE_H
+#define SWITCHCONTROL_UTIL_MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace util {
+
+/**
+ * @brief Bounded lock-free queue for any number of producer tasks and exactly one consumer task.
+ * Each slot carries a sequence number telling producers and the consumer whose turn it is, so producers only
+ * contend on a single atomic counter. The slots are allocated once on the heap.
+ * @tparam T element type, has to be default constructible and move assignable
+ * @tparam N number of slots, has to be a power of two
+ */
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue size has to be a power of two");
+
+   public:
+    MpscQueue() : cells_(new Cell[N]) {
+        for (size_t i = 0; i < N; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * @brief Push a new element. May be called from any task.
+     * @param item the element
+     * @return false if the queue is full and the element was dropped
+     */
+    bool push(T &&item) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells_[pos & (N - 1)];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop the oldest element. Must only be called from the consumer.
+     * @param item receives the element
+     * @return false if the queue was empty
+     */
+    bool pop(T &item) {
+        Cell &cell = cells_[tail_ & (N - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+            return false;
+        }
+        item = std::move(cell.data);
+        cell.data = T{};
+        cell.sequence.store(tail_ + N, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    /**
+     * @brief Get the number of queued elements. Must only be called from the consumer, concurrent pushes may or may
+     * not be counted.
+     */
+    [[nodiscard]] size_t size() const { return head_.load(std::memory_order_relaxed) - tail_; }
+
+   private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T data{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<size_t> head_{0};
+    size_t tail_{0};
+};
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_MPSCQUEUE_H
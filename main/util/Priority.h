@@ -0,0 +1,37 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SWITCHCONTROL_UTIL_PRIORITY_H
+#define SWITCHCONTROL_UTIL_PRIORITY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+/**
+ * @brief Priority class of a pending action, a lower value is started first.
+ * Kept apart from the controller, the metrics record a histogram per class.
+ */
+enum class Priority : uint8_t { eManual = 0, eLocal = 1, eRemote = 2 };
+
+constexpr inline size_t kPriorityCount = 3;
+
+const char *priorityName(Priority priority);
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_PRIORITY_H
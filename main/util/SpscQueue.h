@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_UTIL_SPSCQUEUE_H
+#define SWITCHCONTROL_UTIL_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace util {
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer and one consumer task.
+ * One slot is kept free to distinguish a full from an empty queue, so the capacity is N - 1.
+ * @tparam T element type, has to be default constructible and move assignable
+ * @tparam N number of slots, has to be a power of two
+ */
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size has to be a power of two");
+
+   public:
+    /**
+     * @brief Push a new element. Must only be called from the producer.
+     * @param item the element
+     * @return false if the queue is full and the element was dropped
+     */
+    bool push(T item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) & (N - 1);
+        if (next == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        buffer_[head] = std::move(item);
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop the oldest element. Must only be called from the consumer.
+     * @param item receives the element
+     * @return false if the queue was empty
+     */
+    bool pop(T &item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(buffer_[tail]);
+        tail_.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return (head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+   private:
+    std::array<T, N> buffer_{};
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+};
+}  // namespace util
+
+#endif  // SWITCHCONTROL_UTIL_SPSCQUEUE_H
@@ -21,6 +21,7 @@
 
 #include "AbstractRequestHandler.h"
 #include "ConfigurationServer.h"
+#include "util/Metrics.h"
 
 namespace httpserver {
 #define CORS_HEADER
@@ -33,16 +34,22 @@ static esp_err_t internalHandle(httpd_req_t *req) {
     httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "*");
 #endif
     auto val = reinterpret_cast<AbstractRequestHandler *>(req->user_ctx);
-    auto ret = val->handleRequest(req);
+    esp_err_t ret;
+    {
+        const util::Stopwatch stopwatch(val->latency_);
+        ret = val->handleRequest(req);
+    }
     ESP_LOGD("http", "Exiting internal handle callback %d", ret);
     return ret;
 }
 
-AbstractRequestHandler::AbstractRequestHandler(ConfigurationServer &srv, const char *path, http_method method)
+AbstractRequestHandler::AbstractRequestHandler(ConfigurationServer &srv, const char *path, http_method method,
+                                               bool websocket)
     : srv_(srv) {
     memset(&desc_, 0, sizeof(httpd_uri_t));
     desc_.uri = path;
     desc_.method = method;
+    desc_.is_websocket = websocket;
     desc_.user_ctx = this;
     desc_.handler = &internalHandle;
     httpd_register_uri_handler(srv.handle(), &desc_);
@@ -62,17 +69,8 @@ std::string AbstractRequestHandler::getParamKey(const std::string &val, httpd_re
 }
 
 nlohmann::json AbstractRequestHandler::getJsonBody(httpd_req_t *req) {
-    auto buf = std::make_unique<char[]>(req->content_len + 1);
-    int ret = httpd_req_recv(req, buf.get(), req->content_len);
-    if (ret <= 0) {
-        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-            ESP_LOGW("http", "request timeout");
-            throw std::runtime_error("request timeout");
-        }
-        ESP_LOGW("http", "failed to receive buffer");
-        throw std::runtime_error("failed to receive buffer");
-    }
-    return nlohmann::json::parse(buf.get(), buf.get() + req->content_len, nullptr, false);
+    RequestBody body(req);
+    return nlohmann::json::parse(body.begin(), body.end());
 }
 
 void AbstractRequestHandler::sendEmptySuccess(httpd_req_t *req) {
@@ -80,15 +78,18 @@ void AbstractRequestHandler::sendEmptySuccess(httpd_req_t *req) {
     httpd_resp_send(req, "", HTTPD_RESP_USE_STRLEN);
 }
 
-void AbstractRequestHandler::sendJsonAnswer(httpd_req_t *req, const nlohmann::json &j) {
+void AbstractRequestHandler::sendJsonStream(httpd_req_t *req, const std::function<void(util::JsonWriter &)> &fn) {
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, j.dump().c_str(), HTTPD_RESP_USE_STRLEN);
+    util::JsonWriter writer(
+        [req](const char *data, size_t len) { return httpd_resp_send_chunk(req, data, len) == ESP_OK; });
+    fn(writer);
+    if (writer.flush()) {
+        httpd_resp_send_chunk(req, nullptr, 0);
+    }
 }
 
 void AbstractRequestHandler::sendJsonError(httpd_req_t *req, const std::string &err) {
-    httpd_resp_set_type(req, "application/json");
     httpd_resp_set_status(req, "401");
-    nlohmann::json body = {{"error", err}};
-    httpd_resp_send(req, body.dump().c_str(), HTTPD_RESP_USE_STRLEN);
+    sendJsonStream(req, [&err](util::JsonWriter &w) { w.beginObject().field("error", err).endObject(); });
 }
 }  // namespace httpserver
\ No newline at end of file
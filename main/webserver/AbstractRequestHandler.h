@@ -22,28 +22,56 @@
 
 #include <esp_http_server.h>
 
+#include <functional>
 #include <string>
 
 #include "ConfigurationServer.h"
+#include "RequestBody.h"
+#include "util/Histogram.h"
+#include "util/JsonWriter.h"
 
 namespace httpserver {
 class AbstractRequestHandler {
    public:
-    AbstractRequestHandler(ConfigurationServer &srv, const char *path, http_method method);
+    AbstractRequestHandler(ConfigurationServer &srv, const char *path, http_method method, bool websocket = false);
     virtual ~AbstractRequestHandler() = default;
 
    protected:
     static std::string getParamKey(const std::string &val, httpd_req_t *req);
 
+    /**
+     * @brief Parse the request body, read in chunks and limited to RequestBody::kMaxBodySize.
+     * @throws std::exception if the body is too large, can't be received or isn't valid json
+     */
     static nlohmann::json getJsonBody(httpd_req_t *req);
 
+    /**
+     * @brief Feed the request body into a SAX handler without building a json document.
+     * @throws std::exception if the body is too large or can't be received
+     */
+    template <typename Sax>
+    static void parseJsonBody(httpd_req_t *req, Sax &sax) {
+        RequestBody body(req);
+        nlohmann::json::sax_parse(body.begin(), body.end(), &sax);
+    }
+
     static void sendEmptySuccess(httpd_req_t *req);
-    static void sendJsonAnswer(httpd_req_t *req, const nlohmann::json &j);
+    /**
+     * @brief Send a json document, serialized in chunks while it is written.
+     * @param fn writes the document
+     */
+    static void sendJsonStream(httpd_req_t *req, const std::function<void(util::JsonWriter &)> &fn);
+    template <typename T>
+    static void sendJsonAnswer(httpd_req_t *req, const T &value) {
+        sendJsonStream(req, [&value](util::JsonWriter &w) { w.value(value); });
+    }
+    static void sendJsonAnswer(httpd_req_t *req, const nlohmann::json &j) { sendJsonAnswer<nlohmann::json>(req, j); }
     static void sendJsonError(httpd_req_t *req, const std::string &err);
 
    public:
     ConfigurationServer &srv_;
     httpd_uri_t desc_{};
+    util::Histogram latency_;  ///< duration of handleRequest in us
 
     virtual esp_err_t handleRequest(httpd_req_t *req) = 0;
 };
@@ -25,6 +25,12 @@
 #include "requests/ChannelConfig.h"
 #include "requests/ChannelStatus.h"
 #include "requests/EmbedFileGetRequest.h"
+#include "requests/Events.h"
+#include "requests/Log.h"
+#include "requests/Metrics.h"
+#include "requests/OtaUpdateRequest.h"
+#include "requests/PowerConfig.h"
+#include "requests/RouteConfig.h"
 #include "requests/WiFiConfig.h"
 #include "webserver/requests/Status.h"
 
@@ -49,26 +55,47 @@ static bool uri_match(const char *uri1, const char *uri2, size_t len2) {
 
 namespace httpserver {
 
-ConfigurationServer::ConfigurationServer(config::ConfigurationStorage &storage, wifi::WiFiController &wifi, OperationController &ctrl)
-    : storage_(storage), wifi_(wifi), ctrl_(ctrl) {}
+ConfigurationServer::ConfigurationServer(config::ConfigurationStorage &storage, config::PersistenceWorker &persistence,
+                                         wifi::WiFiController &wifi, OperationController &ctrl)
+    : storage_(storage), persistence_(persistence), wifi_(wifi), ctrl_(ctrl) {}
 
 ConfigurationServer::~ConfigurationServer() { stop(); }
 
 bool ConfigurationServer::start() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.stack_size = 8000;
-    config.max_uri_handlers = 12;
+    config.max_uri_handlers = 25;
     config.uri_match_fn = &uri_match;
+    config.core_id = OperationController::kNetworkCore;
     bool success = httpd_start(&server_, &config) == ESP_OK;
 
     handler_.push_back(std::make_unique<OptionsHandler>(*this));
     handler_.push_back(std::make_unique<requests::ConfigSet>(*this));
     handler_.push_back(std::make_unique<requests::ConfigGet>(*this));
     handler_.push_back(std::make_unique<requests::StatusGet>(*this));
+    handler_.push_back(std::make_unique<requests::MetricsGet>(*this));
+    handler_.push_back(std::make_unique<requests::EventsGet>(*this));
+    handler_.push_back(std::make_unique<requests::LogGet>(*this));
+    handler_.push_back(std::make_unique<requests::LogSet>(*this));
     handler_.push_back(std::make_unique<requests::ChannelStatusGet>(*this));
     handler_.push_back(std::make_unique<requests::ChannelStatusPost>(*this));
+    handler_.push_back(std::make_unique<requests::ChannelBatchPost>(*this));
+    handler_.push_back(std::make_unique<requests::ChannelBatchGet>(*this));
+    auto statusSocket = std::make_unique<requests::ChannelStatusSocket>(*this);
+    statusSocket_ = statusSocket.get();
+    ctrl_.setStatusListener([socket = statusSocket.get()](const nlohmann::json &delta) {
+        socket->broadcast("delta", delta);
+    });
+    handler_.push_back(std::move(statusSocket));
     handler_.push_back(std::make_unique<requests::WiFiGet>(*this));
     handler_.push_back(std::make_unique<requests::WiFiSet>(*this));
+    handler_.push_back(std::make_unique<requests::PowerGet>(*this));
+    handler_.push_back(std::make_unique<requests::PowerSet>(*this));
+    handler_.push_back(std::make_unique<requests::RoutesGet>(*this));
+    handler_.push_back(std::make_unique<requests::RoutesSet>(*this));
+    handler_.push_back(std::make_unique<requests::RouteStateGet>(*this));
+    handler_.push_back(std::make_unique<requests::RouteStatePost>(*this));
+    handler_.push_back(std::make_unique<requests::OtaUpdateRequest>(*this));
     handler_.push_back(std::make_unique<requests::EmbedFileGetRequest>(*this, requests::EmbedFileConfiguration::kFavicon));
     handler_.push_back(std::make_unique<requests::EmbedFileGetRequest>(*this, requests::EmbedFileConfiguration::kIndexHtml));
 
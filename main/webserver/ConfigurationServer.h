@@ -23,18 +23,44 @@
 #include <esp_http_server.h>
 
 #include <memory>
+#include <nlohmann/json.hpp>
 
 #include "config/ConfigurationStorage.h"
 #include "config/GpioConfig.h"
+#include "config/PersistenceWorker.h"
 #include "controller/OperationController.h"
 #include "wifi/WiFiController.h"
 
 namespace httpserver {
 class AbstractRequestHandler;
+namespace requests {
+class ChannelStatusSocket;
+}
+
+/**
+ * @brief Progress of the latest firmware update, only accessed by the http server task.
+ */
+struct UpdateProgress {
+    enum class State { eIdle, eReceiving, eFailed, eUpdated };
+
+    State state{State::eIdle};
+    size_t received{0};
+    size_t size{0};
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(UpdateProgress::State, {{UpdateProgress::State::eIdle, "Idle"},
+                                                     {UpdateProgress::State::eReceiving, "Receiving"},
+                                                     {UpdateProgress::State::eFailed, "Failed"},
+                                                     {UpdateProgress::State::eUpdated, "Updated"}})
+
+inline void to_json(nlohmann::json &j, const UpdateProgress &progress) {
+    j = nlohmann::json{{"state", progress.state}, {"received", progress.received}, {"size", progress.size}};
+}
 
 class ConfigurationServer {
    public:
-    explicit ConfigurationServer(config::ConfigurationStorage &storage, wifi::WiFiController &wifi, OperationController &ctrl);
+    ConfigurationServer(config::ConfigurationStorage &storage, config::PersistenceWorker &persistence,
+                        wifi::WiFiController &wifi, OperationController &ctrl);
 
     ~ConfigurationServer();
 
@@ -45,15 +71,22 @@ class ConfigurationServer {
     [[nodiscard]] httpd_handle_t handle() { return server_; }
 
     [[nodiscard]] config::ConfigurationStorage &getStorage() { return storage_; }
+    [[nodiscard]] config::PersistenceWorker &getPersistence() { return persistence_; }
     [[nodiscard]] wifi::WiFiController &getWifi() { return wifi_; }
     [[nodiscard]] OperationController &getController() { return ctrl_; }
+    [[nodiscard]] const std::vector<std::unique_ptr<AbstractRequestHandler>> &getHandlers() const { return handler_; }
+    [[nodiscard]] requests::ChannelStatusSocket &getStatusSocket() { return *statusSocket_; }
+    [[nodiscard]] UpdateProgress &getUpdateProgress() { return update_; }
 
    private:
     std::vector<std::unique_ptr<AbstractRequestHandler>> handler_;
     config::ConfigurationStorage &storage_;
+    config::PersistenceWorker &persistence_;
     wifi::WiFiController &wifi_;
     OperationController &ctrl_;
     httpd_handle_t server_{nullptr};
+    requests::ChannelStatusSocket *statusSocket_{nullptr};
+    UpdateProgress update_;
 };
 
 }  // namespace httpserver
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RequestBody.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace httpserver {
+static const inline int kMaxTimeouts = 3;
+
+RequestBody::RequestBody(httpd_req_t *req) : req_(req), remaining_(req->content_len) {
+    if (remaining_ == 0) {
+        throw std::runtime_error("request body missing");
+    }
+    if (remaining_ > kMaxBodySize) {
+        ESP_LOGW("http", "rejecting request body of %zu byte", req->content_len);
+        throw std::runtime_error("request body too large");
+    }
+}
+
+bool RequestBody::fill() {
+    if (pos_ < len_) {
+        return true;
+    }
+    if (remaining_ == 0) {
+        return false;
+    }
+
+    int timeouts = 0;
+    while (true) {
+        int ret = httpd_req_recv(req_, buf_.data(), std::min(buf_.size(), remaining_));
+        if (ret > 0) {
+            pos_ = 0;
+            len_ = ret;
+            remaining_ -= ret;
+            return true;
+        }
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < kMaxTimeouts) {
+            continue;
+        }
+        ESP_LOGW("http", "failed to receive request body: %d", ret);
+        throw std::runtime_error(ret == HTTPD_SOCK_ERR_TIMEOUT ? "request timeout" : "failed to receive buffer");
+    }
+}
+}  // namespace httpserver
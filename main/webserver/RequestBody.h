@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_WEBSERVER_REQUESTBODY_H
+#define SWITCHCONTROL_WEBSERVER_REQUESTBODY_H
+
+#include <esp_http_server.h>
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+namespace httpserver {
+
+/**
+ * @brief Reads the body of a request from the socket in small chunks.
+ * Short reads and timeouts are retried, the body has to fit the size limit.
+ */
+class RequestBody {
+   public:
+    static constexpr size_t kMaxBodySize = 8192;
+    static constexpr size_t kChunkSize = 256;
+
+    /**
+     * @brief Input iterator over the characters of the body, as used by the nlohmann parser.
+     */
+    class Iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const char *;
+        using reference = const char &;
+
+        Iterator() = default;
+        explicit Iterator(RequestBody *body) : body_(body) { checkEnd(); }
+
+        reference operator*() const { return body_->buf_[body_->pos_]; }
+        Iterator &operator++() {
+            body_->pos_++;
+            checkEnd();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        bool operator==(const Iterator &rhs) const { return body_ == rhs.body_; }
+        bool operator!=(const Iterator &rhs) const { return body_ != rhs.body_; }
+
+       private:
+        void checkEnd() {
+            if (body_ != nullptr && !body_->fill()) {
+                body_ = nullptr;
+            }
+        }
+
+        RequestBody *body_{nullptr};
+    };
+
+    /**
+     * @throws std::runtime_error if the body is empty or exceeds the size limit
+     */
+    explicit RequestBody(httpd_req_t *req);
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return {}; }
+
+   private:
+    /**
+     * @brief Make sure at least one character is buffered.
+     * @return false at the end of the body
+     * @throws std::runtime_error if receiving failed
+     */
+    bool fill();
+
+    httpd_req_t *req_;
+    size_t remaining_;
+    std::array<char, kChunkSize> buf_{};
+    size_t pos_{0};
+    size_t len_{0};
+};
+}  // namespace httpserver
+
+#endif  // SWITCHCONTROL_WEBSERVER_REQUESTBODY_H
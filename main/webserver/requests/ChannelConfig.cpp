@@ -32,19 +32,26 @@ ConfigGet::ConfigGet(ConfigurationServer &srv)
 esp_err_t ConfigGet::handleRequest(httpd_req_t *req) {
     const std::string &channel = getParamKey("channel", req);
     if (!channel.empty()) {
-        if (!srv_.getStorage().hasConfig(channel)) {
+        auto id = config::findChannel(channel);
+        if (!id.has_value()) {
             httpd_resp_send_404(req);
             ESP_LOGW("http", "channel %s not found", channel.c_str());
             return ESP_OK;
         }
 
         ESP_LOGI("http", "getting configuration for channel %s", channel.c_str());
-        sendJsonAnswer(req, srv_.getStorage().getConfig(channel));
+        sendJsonAnswer(req, srv_.getStorage().getConfig(*id));
         return ESP_OK;
     }
 
     ESP_LOGI("http", "getting configuration for all channels");
-    sendJsonAnswer(req, srv_.getStorage().getChannels());
+    sendJsonStream(req, [this](util::JsonWriter &w) {
+        w.beginArray();
+        for (config::ChannelId i = 0; i < config::kChannelCount; i++) {
+            w.value(srv_.getStorage().getConfig(i));
+        }
+        w.endArray();
+    });
     return ESP_OK;
 }
 
@@ -57,12 +64,13 @@ esp_err_t ConfigSet::handleRequest(httpd_req_t *req) {
     try {
         config::ConfigGpio cfg = getJsonBody(req);
         cfg.validate();
-        ESP_LOGI("http", "saving configuration from buf for channel %s", cfg.channel.c_str());
-        srv_.getStorage().setConfig(cfg.channel, cfg);
+        ESP_LOGI("http", "saving configuration from buf for channel %s", config::channelName(cfg.channel));
         srv_.getController().updateChannel(cfg);
+        srv_.getStorage().setConfig(cfg);
     } catch (const std::exception &e) {
         ESP_LOGW("http", "Failed to set configuration: %s", e.what());
         sendJsonError(req, e.what());
+        return ESP_OK;
     }
 
     sendEmptySuccess(req);
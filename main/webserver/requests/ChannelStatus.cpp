@@ -21,8 +21,15 @@
 
 #include <esp_log.h>
 
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace httpserver::requests {
 inline static const char *kConfigPath = "/api/channel";
+inline static const char *kBatchPath = "/api/channel/batch";
 
 ChannelStatusGet::ChannelStatusGet(ConfigurationServer &srv)
     : AbstractRequestHandler(srv, kConfigPath, HTTP_GET) {}
@@ -37,7 +44,9 @@ ChannelStatusPost::ChannelStatusPost(ConfigurationServer &srv)
 
 esp_err_t ChannelStatusPost::handleRequest(httpd_req_t *req) {
     try {
-        config::SwitchAction payload = getJsonBody(req);
+        config::SwitchActionReader reader;
+        parseJsonBody(req, reader);
+        config::SwitchAction payload = reader.result();
         payload.validate();
         if (payload.direction == config::SwitchDirection::eCustom) {
            srv_.getController().forceSwitchChange(payload);
@@ -48,9 +57,124 @@ esp_err_t ChannelStatusPost::handleRequest(httpd_req_t *req) {
     } catch (const std::exception &e) {
         ESP_LOGW("http", "Failed to set temporary state");
         sendJsonError(req, e.what());
+        return ESP_OK;
     }
     sendEmptySuccess(req);
     return ESP_OK;
 }
 
+ChannelBatchPost::ChannelBatchPost(ConfigurationServer &srv)
+    : AbstractRequestHandler(srv, kBatchPath, HTTP_POST) {}
+
+esp_err_t ChannelBatchPost::handleRequest(httpd_req_t *req) {
+    controller::RouteId route;
+    try {
+        std::vector<config::SwitchAction> actions = getJsonBody(req);
+        if (actions.empty()) {
+            throw std::invalid_argument("A route needs at least one action.");
+        }
+        for (const auto &action : actions) {
+            action.validate();
+        }
+        route = srv_.getController().requestSwitchChange(actions);
+        ESP_LOGI("http", "Queued route %lu with %zu changes.", static_cast<unsigned long>(route), actions.size());
+    } catch (const std::exception &e) {
+        ESP_LOGW("http", "Failed to queue route: %s", e.what());
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    sendJsonAnswer(req, nlohmann::json{{"route", route}});
+    return ESP_OK;
+}
+
+ChannelBatchGet::ChannelBatchGet(ConfigurationServer &srv)
+    : AbstractRequestHandler(srv, kBatchPath, HTTP_GET) {}
+
+esp_err_t ChannelBatchGet::handleRequest(httpd_req_t *req) {
+    const std::string &param = getParamKey("route", req);
+    controller::RouteId id = std::strtoul(param.c_str(), nullptr, 10);
+    auto status = srv_.getController().getRouteStatus(id);
+    if (!status.has_value()) {
+        ESP_LOGW("http", "route %s not found", param.c_str());
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+    sendJsonAnswer(req, nlohmann::json(*status));
+    return ESP_OK;
+}
+
+ChannelStatusSocket::ChannelStatusSocket(ConfigurationServer &srv)
+    : AbstractRequestHandler(srv, "/api/channel/ws", HTTP_GET, true) {}
+
+esp_err_t ChannelStatusSocket::handleRequest(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        ESP_LOGI("http", "New channel status subscriber");
+        send(httpd_req_to_sockfd(req), "snapshot", srv_.getController().generateStatus());
+        return ESP_OK;
+    }
+
+    // clients aren't expected to send anything, drop all frames
+    httpd_ws_frame_t frame{};
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK || frame.len == 0) {
+        return ret;
+    }
+    auto buf = std::make_unique<uint8_t[]>(frame.len);
+    frame.payload = buf.get();
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
+
+/**
+ * @brief A message waiting to be sent by the http server task.
+ */
+struct PendingMessage {
+    httpd_handle_t server;
+    int fd;  ///< the receiving client, -1 for all clients
+    std::string payload;
+};
+
+void ChannelStatusSocket::broadcast(const char *type, const nlohmann::json &channels) { send(-1, type, channels); }
+
+void ChannelStatusSocket::send(int fd, const char *type, const nlohmann::json &channels) {
+    nlohmann::json msg = {{"type", type}, {"channels", channels}};
+    auto *pending = new PendingMessage{srv_.handle(), fd, msg.dump()};
+    if (httpd_queue_work(pending->server, &ChannelStatusSocket::sendWork, pending) != ESP_OK) {
+        ESP_LOGW("http", "Unable to queue channel status message");
+        delete pending;
+    }
+}
+
+void ChannelStatusSocket::broadcastNow(const nlohmann::json &msg) {
+    std::string payload = msg.dump();
+    sendFrames(srv_.handle(), -1, payload);
+}
+
+void ChannelStatusSocket::sendWork(void *arg) {
+    std::unique_ptr<PendingMessage> pending(static_cast<PendingMessage *>(arg));
+    sendFrames(pending->server, pending->fd, pending->payload);
+}
+
+void ChannelStatusSocket::sendFrames(httpd_handle_t server, int fd, std::string &payload) {
+    httpd_ws_frame_t frame{};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = reinterpret_cast<uint8_t *>(payload.data());
+    frame.len = payload.size();
+
+    if (fd >= 0) {
+        httpd_ws_send_frame_async(server, fd, &frame);
+        return;
+    }
+
+    std::array<int, CONFIG_LWIP_MAX_SOCKETS> fds{};
+    size_t count = fds.size();
+    if (httpd_get_client_list(server, &count, fds.data()) != ESP_OK) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (httpd_ws_get_fd_info(server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            httpd_ws_send_frame_async(server, fds[i], &frame);
+        }
+    }
 }
+}  // namespace httpserver::requests
@@ -20,6 +20,8 @@
 #ifndef SWITCHCONTROL_WEBSERVER_REQUESTS_CHANNELSTATUS_H
 #define SWITCHCONTROL_WEBSERVER_REQUESTS_CHANNELSTATUS_H
 
+#include <string>
+
 #include "../AbstractRequestHandler.h"
 
 namespace httpserver::requests {
@@ -38,6 +40,60 @@ class ChannelStatusPost : public AbstractRequestHandler {
 
     esp_err_t handleRequest(httpd_req_t *req) override;
 };
+
+/**
+ * @brief Queue the changes of a whole route at once.
+ * All actions are validated before any of them is queued, the answer contains the id of the route.
+ */
+class ChannelBatchPost : public AbstractRequestHandler {
+   public:
+    explicit ChannelBatchPost(ConfigurationServer &srv);
+    ~ChannelBatchPost() override = default;
+
+    esp_err_t handleRequest(httpd_req_t *req) override;
+};
+
+/**
+ * @brief Query the completion of a route queued by ChannelBatchPost.
+ */
+class ChannelBatchGet : public AbstractRequestHandler {
+   public:
+    explicit ChannelBatchGet(ConfigurationServer &srv);
+    ~ChannelBatchGet() override = default;
+
+    esp_err_t handleRequest(httpd_req_t *req) override;
+};
+
+/**
+ * @brief WebSocket pushing the channel status.
+ * A new client receives the whole status, afterwards only the states of channels which changed are sent.
+ */
+class ChannelStatusSocket : public AbstractRequestHandler {
+   public:
+    explicit ChannelStatusSocket(ConfigurationServer &srv);
+    ~ChannelStatusSocket() override = default;
+
+    esp_err_t handleRequest(httpd_req_t *req) override;
+
+    /**
+     * @brief Send a message to all connected clients. May be called from any task.
+     * @param type the message type, either "snapshot" or "delta"
+     * @param channels the channel states
+     */
+    void broadcast(const char *type, const nlohmann::json &channels);
+
+    /**
+     * @brief Send a message to all connected clients right away, only from the http server task.
+     * A handler blocking the server task, e.g. a firmware update, uses it since queued messages wait for the handler.
+     * @param msg the whole message including its type
+     */
+    void broadcastNow(const nlohmann::json &msg);
+
+   private:
+    void send(int fd, const char *type, const nlohmann::json &channels);
+    static void sendWork(void *arg);
+    static void sendFrames(httpd_handle_t server, int fd, std::string &payload);
+};
 }
 
 #endif  // SWITCHCONTROL_WEBSERVER_REQUESTS_CHANNELSTATUS_H
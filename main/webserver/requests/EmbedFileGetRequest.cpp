@@ -19,24 +19,146 @@
 
 #include "EmbedFileGetRequest.h"
 
+#include <esp_rom_crc.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+#include <vector>
+
 extern const uint8_t index_html_start[] asm("_binary_index_html_start");
 extern const uint8_t index_html_end[] asm("_binary_index_html_end");
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
 
 extern const uint8_t favicon_ico_start[] asm("_binary_favicon_ico_start");
 extern const uint8_t favicon_ico_end[] asm("_binary_favicon_ico_end");
+extern const uint8_t favicon_ico_gz_start[] asm("_binary_favicon_ico_gz_start");
+extern const uint8_t favicon_ico_gz_end[] asm("_binary_favicon_ico_gz_end");
 
 namespace httpserver::requests {
-const EmbedFileConfiguration EmbedFileConfiguration::kIndexHtml = {"!/api", "text/html; charset=utf-8",
-                                                                   index_html_start, index_html_end};
+const EmbedFileConfiguration EmbedFileConfiguration::kIndexHtml = {
+    "!/api", "text/html; charset=utf-8", index_html_start, index_html_end, index_html_gz_start, index_html_gz_end};
 
-const EmbedFileConfiguration EmbedFileConfiguration::kFavicon = {"/favicon.ico", "image/x-icon", favicon_ico_start,
-                                                                 favicon_ico_end};
+const EmbedFileConfiguration EmbedFileConfiguration::kFavicon = {
+    "/favicon.ico", "image/x-icon", favicon_ico_start, favicon_ico_end, favicon_ico_gz_start, favicon_ico_gz_end};
 
 EmbedFileGetRequest::EmbedFileGetRequest(httpserver::ConfigurationServer &srv, const EmbedFileConfiguration &cfg)
-    : AbstractRequestHandler(srv, cfg.path, HTTP_GET), cfg_(cfg) {}
+    : AbstractRequestHandler(srv, cfg.path, HTTP_GET), cfg_(cfg) {
+    uint32_t size = cfg_.end_data - cfg_.start_data;
+    uint32_t crc = esp_rom_crc32_le(0, cfg_.start_data, size);
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"%08" PRIx32 "-%" PRIx32 "\"", crc, size);
+    etag_ = etag;
+    snprintf(etag, sizeof(etag), "\"%08" PRIx32 "-%" PRIx32 "-gz\"", crc, size);
+    gzipEtag_ = etag;
+}
+
+std::string EmbedFileGetRequest::getHeaderValue(httpd_req_t *req, const char *field) {
+    size_t len = httpd_req_get_hdr_value_len(req, field);
+    if (len == 0) {
+        return {};
+    }
+    std::vector<char> buf(len + 1);
+    if (httpd_req_get_hdr_value_str(req, field, buf.data(), buf.size()) != ESP_OK) {
+        return {};
+    }
+    return {buf.data(), len};
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/**
+ * @brief Call a function with every trimmed, non-empty element of a header value.
+ */
+template <typename F>
+static void forEachToken(std::string_view value, char separator, F &&f) {
+    while (!value.empty()) {
+        size_t end = std::min(value.find(separator), value.size());
+        std::string_view token = trim(value.substr(0, end));
+        if (!token.empty()) {
+            f(token);
+        }
+        value.remove_prefix(std::min(end + 1, value.size()));
+    }
+}
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+/**
+ * @brief Check whether an Accept-Encoding header allows gzip. A coding with q=0 is refused, gzip listed on its own
+ * takes precedence over "*".
+ */
+static bool acceptsGzip(std::string_view header) {
+    std::optional<bool> gzip;
+    bool any = false;
+    forEachToken(header, ',', [&](std::string_view token) {
+        size_t params = std::min(token.find(';'), token.size());
+        std::string_view coding = trim(token.substr(0, params));
+        bool accepted = true;
+        forEachToken(token.substr(params), ';', [&](std::string_view param) {
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                accepted = std::strtod(std::string(param.substr(2)).c_str(), nullptr) > 0;
+            }
+        });
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) {
+            gzip = accepted;
+        } else if (coding == "*") {
+            any = accepted;
+        }
+    });
+    return gzip.value_or(any);
+}
+
+/**
+ * @brief Check whether an If-None-Match header lists an ETag, weak ones compare equal as well.
+ */
+static bool matchesEtag(std::string_view header, std::string_view etag) {
+    bool match = false;
+    forEachToken(header, ',', [&](std::string_view token) {
+        if (token.substr(0, 2) == "W/") {
+            token.remove_prefix(2);
+        }
+        match |= token == etag || token == "*";
+    });
+    return match;
+}
 
 esp_err_t EmbedFileGetRequest::handleRequest(httpd_req_t *req) {
+    const bool gzip = cfg_.gzip_start_data != nullptr && acceptsGzip(getHeaderValue(req, "Accept-Encoding"));
+    const std::string &etag = gzip ? gzipEtag_ : etag_;
+    httpd_resp_set_hdr(req, "ETag", etag.c_str());
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (matchesEtag(getHeaderValue(req, "If-None-Match"), etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_send(req, nullptr, 0);
+        return ESP_OK;
+    }
+
     httpd_resp_set_type(req, cfg_.type);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        httpd_resp_send(req, (char *)cfg_.gzip_start_data, cfg_.gzip_end_data - cfg_.gzip_start_data);
+        return ESP_OK;
+    }
     httpd_resp_send(req, (char *)cfg_.start_data, cfg_.end_data - cfg_.start_data);
     return ESP_OK;
 }
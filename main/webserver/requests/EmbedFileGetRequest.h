@@ -20,6 +20,8 @@
 #ifndef SWITCHCONTROL_WEBSERVER_REQUESTS_EMBEDFILEGETREQUEST_H
 #define SWITCHCONTROL_WEBSERVER_REQUESTS_EMBEDFILEGETREQUEST_H
 
+#include <string>
+
 #include "../AbstractRequestHandler.h"
 
 namespace httpserver::requests {
@@ -28,11 +30,19 @@ struct EmbedFileConfiguration {
     const char *type;
     const uint8_t *start_data;
     const uint8_t *end_data;
+    const uint8_t *gzip_start_data;  ///< gzip compressed copy of the file
+    const uint8_t *gzip_end_data;
 
     static const EmbedFileConfiguration kIndexHtml;
     static const EmbedFileConfiguration kFavicon;
 };
 
+/**
+ * @brief Serve an embedded file.
+ * The gzip compressed copy is sent to all clients accepting it. The file carries an ETag derived from its content
+ * and clients are asked to revalidate it, so a cached copy is only transferred again after a firmware update. The
+ * compressed copy has its own ETag, a strong validator differs between content codings.
+ */
 class EmbedFileGetRequest : public AbstractRequestHandler {
    public:
     explicit EmbedFileGetRequest(ConfigurationServer &srv, const EmbedFileConfiguration &cfg);
@@ -42,6 +52,10 @@ class EmbedFileGetRequest : public AbstractRequestHandler {
 
    private:
     const EmbedFileConfiguration &cfg_;
+    std::string etag_;
+    std::string gzipEtag_;
+
+    std::string getHeaderValue(httpd_req_t *req, const char *field);
 };
 }  // namespace httpserver::requests
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Events.h"
+
+#include <esp_log.h>
+
+#include <array>
+#include <cstdlib>
+#include <string>
+
+#include "util/EventLog.h"
+
+namespace httpserver::requests {
+inline static const char *kEventsPath = "/api/events";
+// records copied out of the ring per chunk
+inline static const size_t kChunkRecords = 32;
+
+EventsGet::EventsGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kEventsPath, HTTP_GET) {}
+
+esp_err_t EventsGet::handleRequest(httpd_req_t *req) {
+    const std::string &param = getParamKey("since", req);
+    uint32_t since = std::strtoul(param.c_str(), nullptr, 10);
+    ESP_LOGD("http", "getting events since %lu", static_cast<unsigned long>(since));
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    std::array<util::EventRecord, kChunkRecords> chunk{};
+    // stop at the events present at the start, a busy controller can't keep the response open
+    const uint32_t end = util::events().next();
+    size_t count = 0;
+    do {
+        count = util::events().read(since, chunk.data(), chunk.size());
+        if (count == 0) {
+            break;
+        }
+        if (httpd_resp_send_chunk(req, reinterpret_cast<const char *>(chunk.data()),
+                                  count * sizeof(util::EventRecord)) != ESP_OK) {
+            return ESP_OK;
+        }
+        since = chunk[count - 1].seq + 1;
+    } while (count == chunk.size() && static_cast<int32_t>(end - since) > 0);
+    httpd_resp_send_chunk(req, nullptr, 0);
+    return ESP_OK;
+}
+
+}  // namespace httpserver::requests
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Log.h"
+
+#include <esp_log.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "util/DeferredLog.h"
+
+namespace httpserver::requests {
+
+inline static const char *kLogPath = "/api/log";
+
+LogGet::LogGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kLogPath, HTTP_GET) {}
+
+esp_err_t LogGet::handleRequest(httpd_req_t *req) {
+    const std::string &param = getParamKey("since", req);
+    uint32_t since = std::strtoul(param.c_str(), nullptr, 10);
+    sendJsonStream(req, [since](util::JsonWriter &w) { util::deferredLog().writeStatus(w, since); });
+    return ESP_OK;
+}
+
+LogSet::LogSet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kLogPath, HTTP_POST) {}
+
+esp_err_t LogSet::handleRequest(httpd_req_t *req) {
+    try {
+        nlohmann::json body = getJsonBody(req);
+        auto tag = body.at("tag").get<std::string>();
+        auto level = util::logLevelFromName(body.at("level").get<std::string>());
+        if (tag.empty() || !level.has_value()) {
+            throw std::invalid_argument("Log tag or level is invalid.");
+        }
+        util::deferredLog().setLevel(tag, *level);
+        ESP_LOGI("http", "Set log level of %s to %s", tag.c_str(), util::logLevelName(*level));
+    } catch (const std::exception &e) {
+        ESP_LOGW("http", "Unable to set log level: %s", e.what());
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    sendEmptySuccess(req);
+    return ESP_OK;
+}
+}  // namespace httpserver::requests
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Metrics.h"
+
+#include <esp_log.h>
+
+#include "util/Metrics.h"
+
+namespace httpserver::requests {
+inline static const char *kMetricsPath = "/api/metrics";
+
+MetricsGet::MetricsGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kMetricsPath, HTTP_GET) {}
+
+esp_err_t MetricsGet::handleRequest(httpd_req_t *req) {
+    ESP_LOGD("http", "getting metrics");
+    sendJsonStream(req, [this](util::JsonWriter &w) {
+        w.beginObject();
+        w.field("uptime_us", util::metricsNow());
+        w.field("loop", util::metrics());
+        w.key("endpoints").beginArray();
+        for (const auto &handler : srv_.getHandlers()) {
+            if (handler->latency_.count() == 0) {
+                continue;
+            }
+            w.beginObject();
+            w.field("method", http_method_str(handler->desc_.method));
+            w.field("uri", handler->desc_.uri);
+            w.field("latency_us", handler->latency_);
+            w.endObject();
+        }
+        w.endArray();
+        w.endObject();
+    });
+    return ESP_OK;
+}
+
+}  // namespace httpserver::requests
@@ -19,79 +19,196 @@
 
 #include "OtaUpdateRequest.h"
 
-#include <esp_http_client.h>
-#include <esp_https_ota.h>
 #include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+#include <mbedtls/sha256.h>
 
-extern const uint8_t cert_start[] asm("_binary_cert_pem_start");
-extern const uint8_t cert_end[] asm("_binary_cert_pem_end");
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "ChannelStatus.h"
 
 namespace httpserver::requests {
-void from_json(const nlohmann::json &j, OtaUpdatePayload &p) { p.url = j.at("url").get<std::string>(); }
-
-OtaUpdateRequest::OtaUpdateRequest(ConfigurationServer &srv) : AbstractRequestHeader(srv, "/api/update", HTTP_POST) {}
-
-static esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGD("Update", "HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD("Update", "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGD("Update", "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGD("Update", "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD("Update", "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGD("Update", "HTTP_EVENT_ON_FINISH");
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGD("Update", "HTTP_EVENT_DISCONNECTED");
-            break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGD("Update", "HTTP_EVENT_REDIRECT");
-            break;
+static const inline int kMaxTimeouts = 3;
+static const inline size_t kProgressStep = 64 * 1024;
+static const inline int64_t kRestartDelay = 500 * 1000;
+
+using Digest = std::array<uint8_t, 32>;
+
+static std::string toHex(const Digest &digest) {
+    static const char *kHex = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t b : digest) {
+        hex.push_back(kHex[b >> 4]);
+        hex.push_back(kHex[b & 0xF]);
     }
-    return ESP_OK;
+    return hex;
+}
+
+static std::string getHeader(httpd_req_t *req, const char *field) {
+    size_t len = httpd_req_get_hdr_value_len(req, field);
+    if (len == 0) {
+        return {};
+    }
+    std::string value(len + 1, '\0');
+    if (httpd_req_get_hdr_value_str(req, field, value.data(), value.size()) != ESP_OK) {
+        return {};
+    }
+    value.resize(len);
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+    return value;
 }
 
+namespace {
+/**
+ * @brief Writes an image into an OTA partition, the update is aborted unless it was finished.
+ */
+class OtaWriter {
+   public:
+    explicit OtaWriter(const esp_partition_t *target) : target_(target) {
+        // erase the flash sector by sector while writing instead of erasing the whole partition up front
+        esp_err_t err = esp_ota_begin(target_, OTA_WITH_SEQUENTIAL_WRITES, &handle_);
+        if (err != ESP_OK) {
+            throw std::runtime_error(std::string("Unable to start update: ") + esp_err_to_name(err));
+        }
+        mbedtls_sha256_init(&sha_);
+        mbedtls_sha256_starts(&sha_, 0);
+    }
+    ~OtaWriter() {
+        mbedtls_sha256_free(&sha_);
+        if (!finished_) {
+            esp_ota_abort(handle_);
+        }
+    }
+    OtaWriter(const OtaWriter &) = delete;
+    OtaWriter &operator=(const OtaWriter &) = delete;
+
+    void write(const char *data, size_t len) {
+        mbedtls_sha256_update(&sha_, reinterpret_cast<const unsigned char *>(data), len);
+        esp_err_t err = esp_ota_write(handle_, data, len);
+        if (err != ESP_OK) {
+            throw std::runtime_error(std::string("Unable to write image: ") + esp_err_to_name(err));
+        }
+    }
+
+    /**
+     * @brief Validate the image and select it for the next boot.
+     * @param expected the expected SHA-256 of the image
+     */
+    void finish(const Digest &expected) {
+        Digest digest{};
+        mbedtls_sha256_finish(&sha_, digest.data());
+        if (digest != expected) {
+            throw std::runtime_error("Image checksum mismatch, received " + toHex(digest));
+        }
+        finished_ = true;
+        esp_err_t err = esp_ota_end(handle_);
+        if (err == ESP_OK) {
+            err = esp_ota_set_boot_partition(target_);
+        }
+        if (err != ESP_OK) {
+            throw std::runtime_error(std::string("Image is invalid: ") + esp_err_to_name(err));
+        }
+    }
+
+   private:
+    const esp_partition_t *target_;
+    esp_ota_handle_t handle_{0};
+    mbedtls_sha256_context sha_{};
+    bool finished_{false};
+};
+}  // namespace
+
+static Digest parseDigest(const std::string &hex) {
+    Digest digest{};
+    if (hex.size() != digest.size() * 2 ||
+        !std::all_of(hex.begin(), hex.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); })) {
+        throw std::runtime_error("Header X-Image-SHA256 has to contain the hex encoded SHA-256 of the image.");
+    }
+    for (size_t i = 0; i < digest.size(); i++) {
+        digest[i] = std::stoi(hex.substr(i * 2, 2), nullptr, 16);
+    }
+    return digest;
+}
+
+static void restart(void *) { esp_restart(); }
+
+/**
+ * @brief Push the progress to the WebSocket clients, GET /api/status has to wait until the update ended.
+ */
+static void publishProgress(ConfigurationServer &srv) {
+    srv.getStatusSocket().broadcastNow(nlohmann::json{{"type", "update"}, {"update", srv.getUpdateProgress()}});
+}
+
+OtaUpdateRequest::OtaUpdateRequest(ConfigurationServer &srv) : AbstractRequestHandler(srv, "/api/update", HTTP_POST) {}
+
 esp_err_t OtaUpdateRequest::handleRequest(httpd_req_t *req) {
-    OtaUpdatePayload payload = getJsonBody(req);
-
-    ESP_LOGI("Update", "Preparing update from %s", payload.url.c_str());
-
-    esp_http_client_config_t config{};
-    memset(&config, 0, sizeof(esp_http_client_config_t));
-    config.url = payload.url.c_str();
-    config.cert_pem = (char *)cert_start;
-    config.skip_cert_common_name_check = true;
-    config.event_handler = &_http_event_handler;
-    config.keep_alive_enable = true;
-    esp_https_ota_config_t ota_config{};
-    memset(&ota_config, 0, sizeof(esp_https_ota_config_t));
-    ota_config.http_config = &config;
-
-    ESP_LOGI("Update", "Updating with ota request.");
-    esp_err_t ret = esp_https_ota(&ota_config);
-
-    if (ret == ESP_OK) {
-        sendJsonAnswer(req, {{"Status", "Accepted"}});
-        ESP_LOGI("Update", "Update was successful, restarting app now.");
+    size_t size = req->content_len;
+    UpdateProgress &progress = srv_.getUpdateProgress();
+    progress = UpdateProgress{UpdateProgress::State::eReceiving, 0, size};
+    try {
+        Digest expected = parseDigest(getHeader(req, "X-Image-SHA256"));
+        const esp_partition_t *target = esp_ota_get_next_update_partition(nullptr);
+        if (target == nullptr) {
+            throw std::runtime_error("No OTA partition available.");
+        }
+        if (size == 0 || size > target->size) {
+            throw std::runtime_error("Image size is invalid: " + std::to_string(size));
+        }
+
+        ESP_LOGI("Update", "Receiving image of %zu byte into partition %s", size, target->label);
+        OtaWriter writer(target);
+        auto buf = std::make_unique<char[]>(kChunkSize);
+        size_t received = 0;
+        size_t nextProgress = kProgressStep;
+        int timeouts = 0;
+        while (received < size) {
+            int ret = httpd_req_recv(req, buf.get(), std::min(kChunkSize, size - received));
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < kMaxTimeouts) {
+                continue;
+            }
+            if (ret <= 0) {
+                throw std::runtime_error("Failed to receive image: " + std::to_string(ret));
+            }
+            timeouts = 0;
+            writer.write(buf.get(), ret);
+            received += ret;
+            if (received >= nextProgress || received == size) {
+                ESP_LOGI("Update", "Received %zu of %zu byte (%zu%%)", received, size, received * 100 / size);
+                progress.received = received;
+                publishProgress(srv_);
+                nextProgress += kProgressStep;
+            }
+        }
+        writer.finish(expected);
+    } catch (const std::exception &e) {
+        ESP_LOGW("Update", "Update failed: %s", e.what());
+        progress.state = UpdateProgress::State::eFailed;
+        publishProgress(srv_);
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    progress.state = UpdateProgress::State::eUpdated;
+    publishProgress(srv_);
+
+    ESP_LOGI("Update", "Update was successful, restarting app now.");
+    srv_.getPersistence().flush();
+    sendJsonAnswer(req, nlohmann::json{{"status", "Updated"}, {"size", size}});
+
+    // give the answer some time to leave before restarting
+    esp_timer_create_args_t args{};
+    args.callback = &restart;
+    args.name = "ota_restart";
+    esp_timer_handle_t timer;
+    if (esp_timer_create(&args, &timer) != ESP_OK || esp_timer_start_once(timer, kRestartDelay) != ESP_OK) {
         esp_restart();
-    } else {
-        ESP_LOGW("Update", "Update failed with error %d.", ret);
-        httpd_resp_set_status(req, "500");
-        sendJsonAnswer(req, {{"Status", "Failed"}, {"Return Key", ret}});
-        return ESP_FAIL;
     }
     return ESP_OK;
 }
-
 }  // namespace httpserver::requests
-// http
\ No newline at end of file
@@ -24,21 +24,20 @@
 
 namespace httpserver::requests {
 
-class OtaUpdatePayload {
+/**
+ * @brief Receive a new application image and write it into the next OTA partition.
+ * The image is streamed from the request body into flash in fixed-size chunks while its SHA-256 is calculated. The
+ * board boots the new image after the digest matches the X-Image-SHA256 header and the image was validated.
+ */
+class OtaUpdateRequest : public AbstractRequestHandler {
    public:
-    std::string url;
-};
+    static constexpr size_t kChunkSize = 4096;
 
-void from_json(const nlohmann::json &j, OtaUpdatePayload &p);
-
-class OtaUpdateRequest : public AbstractRequestHeader {
-   public:
     explicit OtaUpdateRequest(ConfigurationServer &srv);
     ~OtaUpdateRequest() override = default;
 
     esp_err_t handleRequest(httpd_req_t *req) override;
 };
 }  // namespace httpserver::requests
-// http
 
 #endif  // SWITCHCONTROL_WEBSERVER_REQUESTS_OTAUPDATEREQUEST_H
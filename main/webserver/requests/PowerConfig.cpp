@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PowerConfig.h"
+
+#include <esp_log.h>
+
+#include "config/PowerConfig.h"
+
+namespace httpserver::requests {
+
+inline static const char *kPowerPath = "/api/power";
+
+PowerGet::PowerGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kPowerPath, HTTP_GET) {}
+
+esp_err_t PowerGet::handleRequest(httpd_req_t *req) {
+    ESP_LOGI("http", "getting power configuration");
+    sendJsonAnswer(req, srv_.getController().getPowerConfig());
+    return ESP_OK;
+}
+
+PowerSet::PowerSet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kPowerPath, HTTP_POST) {}
+
+esp_err_t PowerSet::handleRequest(httpd_req_t *req) {
+    try {
+        config::PowerConfig cfg = getJsonBody(req);
+        cfg.validate();
+        srv_.getController().setPowerConfig(cfg);
+        srv_.getPersistence().savePower(cfg);
+    } catch (const std::exception &e) {
+        ESP_LOGW("http", "Unable to process power configuration: %s", e.what());
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    sendEmptySuccess(req);
+    return ESP_OK;
+}
+}  // namespace httpserver::requests
@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RouteConfig.h"
+
+#include <esp_log.h>
+
+#include "config/RouteConfig.h"
+
+namespace httpserver::requests {
+
+inline static const char *kRoutesPath = "/api/routes";
+inline static const char *kRouteStatePath = "/api/routes/state";
+
+RoutesGet::RoutesGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kRoutesPath, HTTP_GET) {}
+
+esp_err_t RoutesGet::handleRequest(httpd_req_t *req) {
+    ESP_LOGI("http", "getting routes");
+    sendJsonAnswer(req, srv_.getController().getRoutes());
+    return ESP_OK;
+}
+
+RoutesSet::RoutesSet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kRoutesPath, HTTP_POST) {}
+
+esp_err_t RoutesSet::handleRequest(httpd_req_t *req) {
+    try {
+        config::RouteConfig cfg = getJsonBody(req);
+        cfg.validate();
+        srv_.getController().setRoutes(cfg);
+        srv_.getPersistence().saveRoutes(cfg);
+    } catch (const std::exception &e) {
+        ESP_LOGW("http", "Unable to process routes: %s", e.what());
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    sendEmptySuccess(req);
+    return ESP_OK;
+}
+
+RouteStateGet::RouteStateGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kRouteStatePath, HTTP_GET) {}
+
+esp_err_t RouteStateGet::handleRequest(httpd_req_t *req) {
+    sendJsonAnswer(req, srv_.getController().generateRouteStatus());
+    return ESP_OK;
+}
+
+RouteStatePost::RouteStatePost(ConfigurationServer &srv) : AbstractRequestHandler(srv, kRouteStatePath, HTTP_POST) {}
+
+esp_err_t RouteStatePost::handleRequest(httpd_req_t *req) {
+    controller::RouteId route = 0;
+    try {
+        nlohmann::json body = getJsonBody(req);
+        auto name = body.at("name").get<std::string>();
+        bool locked = body.at("locked").get<bool>();
+        if (!srv_.getController().getRoutes().find(name).has_value()) {
+            throw std::runtime_error("Unknown route: " + name);
+        }
+        if (locked) {
+            route = srv_.getController().lockRoute(name);
+        } else {
+            srv_.getController().releaseRoute(name);
+        }
+    } catch (const std::exception &e) {
+        ESP_LOGW("http", "Unable to change route state: %s", e.what());
+        sendJsonError(req, e.what());
+        return ESP_OK;
+    }
+    if (route == 0) {
+        sendEmptySuccess(req);
+    } else {
+        sendJsonAnswer(req, nlohmann::json{{"route", route}});
+    }
+    return ESP_OK;
+}
+}  // namespace httpserver::requests
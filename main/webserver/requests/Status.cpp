@@ -40,38 +40,53 @@ inline static const char *kStatusPath = "/api/status";
 
 StatusGet::StatusGet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kStatusPath, HTTP_GET) {}
 
-static nlohmann::json getChipInfo() {
-    nlohmann::json chipinfo;
+static void writeChipInfo(util::JsonWriter &w) {
     esp_chip_info_t chip;
     esp_chip_info(&chip);
-    chipinfo["model"] = chip.model;
-    chipinfo["cores"] = chip.cores;
-    chipinfo["revision"] = chip.revision;
-    chipinfo["features"] = chip.features;
-    return chipinfo;
+    w.beginObject();
+    w.field("model", chip.model);
+    w.field("cores", chip.cores);
+    w.field("revision", chip.revision);
+    w.field("features", chip.features);
+    w.endObject();
 }
 
-static nlohmann::json getAppInfo() {
-    nlohmann::json app;
+static void writeAppInfo(util::JsonWriter &w) {
     const esp_app_desc_t *data = esp_app_get_description();
-    app["name"] = data->project_name;
-    app["version"] = data->version;
-    app["git"] = APP_GIT_VERSION;
-    app["idf-version"] = data->idf_ver;
-    app["sha256"] = esp_app_get_elf_sha256_str();
-    app["time"] = data->time;
-    app["date"] = data->date;
-    return app;
+    w.beginObject();
+    w.field("name", data->project_name);
+    w.field("version", data->version);
+    w.field("git", APP_GIT_VERSION);
+    w.field("idf-version", data->idf_ver);
+    w.field("sha256", esp_app_get_elf_sha256_str());
+    w.field("time", data->time);
+    w.field("date", data->date);
+    w.endObject();
 }
 
-esp_err_t StatusGet::handleRequest(httpd_req_t *req) {
-    nlohmann::json status;
-
-    status["wifi"] = srv_.getWifi().getStatus();
-    status["app"] = getAppInfo();
-    status["chip"] = getChipInfo();
+static void writePendingSaves(util::JsonWriter &w, config::PersistenceWorker &persistence) {
+    w.beginObject();
+    for (auto doc : {config::Document::eChannels, config::Document::eWiFi, config::Document::ePower,
+                     config::Document::eRoutes, config::Document::ePositions}) {
+        w.field(config::documentName(doc), persistence.pending(doc));
+    }
+    w.endObject();
+}
 
-    sendJsonAnswer(req, status);
+esp_err_t StatusGet::handleRequest(httpd_req_t *req) {
+    sendJsonStream(req, [this](util::JsonWriter &w) {
+        w.beginObject();
+        w.key("wifi");
+        srv_.getWifi().writeStatus(w);
+        w.key("app");
+        writeAppInfo(w);
+        w.key("chip");
+        writeChipInfo(w);
+        w.key("pending-save");
+        writePendingSaves(w, srv_.getPersistence());
+        w.field("update", srv_.getUpdateProgress());
+        w.endObject();
+    });
     return ESP_OK;
 }
 
@@ -41,7 +41,7 @@ WiFiSet::WiFiSet(ConfigurationServer &srv) : AbstractRequestHandler(srv, kWiFiPa
 esp_err_t WiFiSet::handleRequest(httpd_req_t *req) {
     try {
         config::WiFiConfig cfg = getJsonBody(req);
-        config::writeWiFi(cfg);
+        srv_.getPersistence().saveWiFi(cfg);
         srv_.getWifi().updateConfig(cfg);
         sendJsonAnswer(req, {{"Status", "Accepted"}});
     } catch (const std::exception &e) {
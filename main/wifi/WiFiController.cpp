@@ -29,6 +29,8 @@
 
 #include <cstring>
 
+#include "util/EventLog.h"
+
 int retry_num = 0;
 enum class ConnectionState { eUnknown = 0, eStarting = 1, eConnected = 2, eIpReceived = 3, eDisconnected = 4 };
 
@@ -44,6 +46,7 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ConnectionState, {
 
 namespace wifi {
 static void wifi_event_handler(void *, esp_event_base_t, int32_t event_id, void *) {
+    ConnectionState previous = curr_state;
     if (event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI("WiFi", "WIFI CONNECTING....");
         curr_state = ConnectionState::eStarting;
@@ -62,6 +65,9 @@ static void wifi_event_handler(void *, esp_event_base_t, int32_t event_id, void
         ESP_LOGI("WiFi", "Wifi got IP...");
         curr_state = ConnectionState::eIpReceived;
     }
+    if (curr_state != previous) {
+        util::events().record(util::EventType::eWiFiState, util::kNoChannel, static_cast<uint16_t>(curr_state));
+    }
 }
 
 void WiFiController::connectToSta() {
@@ -125,7 +131,8 @@ void WiFiController::createAP() {
              cfg_.ap.passphrase.c_str());
 }
 
-WiFiController::WiFiController(const config::WiFiConfig &cfg) : cfg_(cfg) {
+WiFiController::WiFiController(const config::WiFiConfig &cfg, config::PersistenceWorker &persistence)
+    : cfg_(cfg), persistence_(persistence) {
     // 2 - Wi-Fi Configuration Phase
     nvs_flash_init();
     esp_netif_init();
@@ -143,6 +150,7 @@ WiFiController::WiFiController(const config::WiFiConfig &cfg) : cfg_(cfg) {
 }
 
 void WiFiController::updateMode() {
+    util::events().record(util::EventType::eWiFiMode, util::kNoChannel, static_cast<uint16_t>(cfg_.mode));
     if (netif_ != nullptr) {
         esp_netif_destroy_default_wifi(netif_);
         netif_ = nullptr;
@@ -213,7 +221,7 @@ void WiFiController::tick() {
                 cfg_.mode = config::WiFiMode::eOff;
                 break;
         }
-        config::writeWiFi(cfg_);
+        persistence_.saveWiFi(cfg_);
         updateMode();
     }
     updateLED();
@@ -235,12 +243,12 @@ void WiFiController::updateConfig(const config::WiFiConfig &config) {
     this->cfg_ = config;
 }
 
-nlohmann::json WiFiController::getStatus() {
-    nlohmann::json status;
-    status["mode"] = cfg_.mode;
+void WiFiController::writeStatus(util::JsonWriter &w) {
+    w.beginObject();
+    w.field("mode", cfg_.mode);
     if (cfg_.mode == config::WiFiMode::eSta) {
-        status["connected"] = curr_state;
+        w.field("connected", curr_state);
     }
-    return status;
+    w.endObject();
 }
 }  // namespace wifi
\ No newline at end of file
@@ -22,24 +22,27 @@
 
 #include <esp_netif_types.h>
 #include "config/ConfigurationStorage.h"
+#include "config/PersistenceWorker.h"
 #include "config/WiFiConfig.h"
+#include "util/JsonWriter.h"
 
 namespace wifi {
 
 class WiFiController {
    public:
-    explicit WiFiController(const config::WiFiConfig &cfg);
+    WiFiController(const config::WiFiConfig &cfg, config::PersistenceWorker &persistence);
 
     void tick();
 
     void updateConfig(const config::WiFiConfig &config);
 
-    nlohmann::json getStatus();
+    void writeStatus(util::JsonWriter &w);
 
     [[nodiscard]] const config::WiFiConfig &getConfig() { return cfg_; }
 
    private:
     config::WiFiConfig cfg_;
+    config::PersistenceWorker &persistence_;
     esp_netif_t *netif_{nullptr};
 
     void updateMode();
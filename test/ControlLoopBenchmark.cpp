@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include "Simulation.h"
+#include "util/EventLog.h"
+
+using config::SwitchDirection;
+using namespace std::chrono_literals;
+
+/**
+ * Benchmarks of the control loop on the simulation. Latencies are measured in virtual time and therefore exact, only
+ * the tick cost depends on the host. Results are printed and recorded as test properties so runs can be compared.
+ */
+namespace {
+constexpr size_t kServoChannels = 8;
+constexpr std::array<size_t, 5> kChannelCounts = {1, 2, 4, 8, 16};
+constexpr int kTickRuns = 2000;
+
+/**
+ * @brief Set up a board with the given number of channels, servos first and buttons on the remaining channels.
+ * Each button switches all servos.
+ */
+std::vector<config::SwitchAction> populate(sim::Simulation &sim, size_t channels,
+                                           config::MotionProfile profile = config::MotionProfile::eNone) {
+    std::vector<config::SwitchAction> actions;
+    size_t servos = std::min(channels, kServoChannels);
+    for (config::ChannelId ch = 0; ch < servos; ch++) {
+        sim.addServo(ch, profile);
+        actions.push_back(sim::action(ch, SwitchDirection::eRight));
+    }
+    for (auto ch = static_cast<config::ChannelId>(kServoChannels); ch < channels; ch++) {
+        sim.addButton(ch, actions);
+    }
+    // no servo waits for the budget
+    sim.setPowerBudget(static_cast<int>(servos) * 1000);
+    return actions;
+}
+
+void record(const std::string &key, long long value) {
+    testing::Test::RecordProperty(key, std::to_string(value));
+    std::printf("%-32s %10lld\n", key.c_str(), value);
+}
+}  // namespace
+
+TEST(ControlLoopBenchmark, TickCost) {
+    for (size_t channels : kChannelCounts) {
+        sim::Simulation sim;
+        auto actions = populate(sim, channels, config::MotionProfile::eLinear);
+        sim.controller().requestSwitchChange(actions);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kTickRuns; i++) {
+            sim.step();
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        record("tick_ns_" + std::to_string(channels), ns.count() / kTickRuns);
+        EXPECT_GT(sim.pwmWrites(), 0u);
+    }
+}
+
+TEST(ControlLoopBenchmark, ButtonToServoLatency) {
+    for (size_t channels : kChannelCounts) {
+        sim::Simulation sim;
+        auto actions = populate(sim, channels);
+        // a single button on the first channel without a servo
+        auto button = static_cast<config::ChannelId>(std::max(channels, kServoChannels));
+        if (button >= config::kChannelCount) {
+            button = config::kChannelCount - 1;
+        } else {
+            sim.addButton(button, actions);
+        }
+        size_t servos = actions.size();
+
+        sim.setButton(button, true);
+        auto latency = sim.advanceUntil(
+            [&] {
+                for (size_t ch = 0; ch < servos; ch++) {
+                    if (sim.pulseWidth(ch) != 1750) {
+                        return false;
+                    }
+                }
+                return true;
+            },
+            1s);
+        ASSERT_TRUE(latency.has_value()) << channels << " channels";
+        record("button_latency_ms_" + std::to_string(channels), latency->count());
+        EXPECT_LE(*latency, std::chrono::milliseconds(io::ButtonSampler::kSamplePeriodMs *
+                                                      (io::ButtonSampler::kRequiredTicks + 1)));
+    }
+}
+
+TEST(ControlLoopBenchmark, RouteCompletion) {
+    for (size_t channels : kChannelCounts) {
+        sim::Simulation sim;
+        auto actions = populate(sim, channels, config::MotionProfile::eLinear);
+
+        auto route = sim.controller().requestSwitchChange(actions);
+        auto duration = sim.advanceUntil(
+            [&] { return sim.controller().getRouteStatus(route)->state() == controller::RouteState::eDone; }, 5s);
+        ASSERT_TRUE(duration.has_value()) << channels << " channels";
+        record("route_completion_ms_" + std::to_string(channels), duration->count());
+    }
+}
+
+TEST(ControlLoopBenchmark, EventRecordCost) {
+    constexpr int kRecords = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRecords; i++) {
+        util::events().record(util::EventType::eQueued, static_cast<uint8_t>(i % config::kChannelCount));
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    record("event_record_ns", ns.count() / kRecords);
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Simulation.h"
+
+using config::SwitchDirection;
+using namespace std::chrono_literals;
+
+TEST(ControlLoop, ServoOverdrawsAndReleases) {
+    sim::Simulation sim;
+    sim.addServo(0);
+    EXPECT_EQ(sim.pulseWidth(0), 1300);
+
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+
+    sim.advance(500ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+}
+
+TEST(ControlLoop, ButtonPressMovesServo) {
+    sim::Simulation sim;
+    sim.addServo(0);
+    sim.addButton(8, {sim::action(0, SwitchDirection::eRight)});
+
+    sim.setButton(8, true);
+    auto latency = sim.advanceUntil([&] { return sim.pulseWidth(0) == 1750; }, 200ms);
+    ASSERT_TRUE(latency.has_value());
+    // debounced over kRequiredTicks samples
+    EXPECT_LE(*latency, std::chrono::milliseconds(io::ButtonSampler::kSamplePeriodMs *
+                                                  (io::ButtonSampler::kRequiredTicks + 1)));
+}
+
+TEST(ControlLoop, PowerBudgetDelaysMoves) {
+    sim::Simulation sim;
+    for (config::ChannelId ch = 0; ch < 3; ch++) {
+        sim.addServo(ch);
+    }
+
+    // two servos of 500 mA fit into the default budget of 1000 mA
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight),
+                                          sim::action(1, SwitchDirection::eRight),
+                                          sim::action(2, SwitchDirection::eRight)});
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+    EXPECT_EQ(sim.pulseWidth(1), 1750);
+    EXPECT_EQ(sim.pulseWidth(2), 1300);
+
+    sim.advance(400ms);
+    EXPECT_EQ(sim.pulseWidth(2), 1750);
+}
+
+TEST(ControlLoop, UnconfiguredRailUsesDefaultBudget) {
+    sim::Simulation sim;
+    config::PowerConfig power{};
+    power.rails.resize(1);
+    sim.controller().setPowerConfig(power);
+    sim.controller().tick();
+
+    config::ConfigServo servo{};
+    servo.rail = 2;
+    for (config::ChannelId ch = 0; ch < 3; ch++) {
+        sim.addServo(ch, servo);
+    }
+
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight),
+                                          sim::action(1, SwitchDirection::eRight),
+                                          sim::action(2, SwitchDirection::eRight)});
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+    EXPECT_EQ(sim.pulseWidth(1), 1750);
+    EXPECT_EQ(sim.pulseWidth(2), 1300);
+}
+
+TEST(ControlLoop, LockedRouteRejectsSingleRequest) {
+    sim::Simulation sim;
+    sim.addServo(0);
+    config::RouteConfig routes{};
+    routes.routes.push_back({"main", {sim::action(0, SwitchDirection::eRight)}});
+    sim.controller().setRoutes(routes);
+    sim.controller().lockRoute("main");
+    sim.advance(500ms);
+    ASSERT_EQ(sim.pulseWidth(0), 1700);
+
+    EXPECT_THROW(sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eLeft)}),
+                 std::invalid_argument);
+    EXPECT_THROW(sim.controller().forceSwitchChange(sim::action(0, SwitchDirection::eLeft)), std::invalid_argument);
+    sim.advance(500ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+
+    sim.controller().releaseRoute("main");
+    sim.step();
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eLeft)});
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1250);
+}
+
+TEST(ControlLoop, RouteCompletes) {
+    sim::Simulation sim;
+    sim.addServo(0, config::MotionProfile::eLinear);
+    sim.addServo(1);
+
+    auto route = sim.controller().requestSwitchChange(
+        {sim::action(0, SwitchDirection::eRight), sim::action(1, SwitchDirection::eRight)});
+    sim.step();
+    EXPECT_EQ(sim.controller().getRouteStatus(route)->state(), controller::RouteState::ePending);
+
+    auto duration = sim.advanceUntil(
+        [&] { return sim.controller().getRouteStatus(route)->state() == controller::RouteState::eDone; }, 2s);
+    ASSERT_TRUE(duration.has_value());
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+}
+
+TEST(ControlLoop, RequestWithoutTargetIsRejected) {
+    sim::Simulation sim;
+    sim.addServo(0);
+
+    EXPECT_THROW(sim.controller().requestSwitchChange({sim::action(3, SwitchDirection::eRight)}),
+                 std::invalid_argument);
+    auto route = sim.controller().requestSwitchChange(
+        {sim::action(3, SwitchDirection::eRight), sim::action(0, SwitchDirection::eRight)});
+    auto duration = sim.advanceUntil(
+        [&] { return sim.controller().getRouteStatus(route)->state() == controller::RouteState::eDone; }, 2s);
+    EXPECT_TRUE(duration.has_value());
+}
+
+TEST(ControlLoop, RestoredServoDoesNotMove) {
+    sim::Simulation sim;
+    sim.restorePosition(0, {SwitchDirection::eRight, 0});
+    sim.restorePosition(1, {SwitchDirection::eCustom, 1500});
+    sim.addServo(0);
+    sim.addServo(1);
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+    EXPECT_EQ(sim.pulseWidth(1), 1500);
+
+    // already in position, no overdraw
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+}
+
+TEST(ControlLoop, UnknownServosResyncWithinBudget) {
+    sim::Simulation sim;
+    for (config::ChannelId ch = 0; ch < 4; ch++) {
+        sim.restorePosition(ch, {});
+        sim.addServo(ch);
+    }
+
+    // two servos of 500 mA fit into the default budget of 1000 mA, the others stay without pulse
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1250);
+    EXPECT_EQ(sim.pulseWidth(1), 1250);
+    EXPECT_EQ(sim.pulseWidth(2), 0);
+    EXPECT_EQ(sim.pulseWidth(3), 0);
+
+    auto synced = sim.advanceUntil(
+        [&] {
+            for (config::ChannelId ch = 0; ch < 4; ch++) {
+                if (sim.pulseWidth(ch) != 1300) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        2s);
+    ASSERT_TRUE(synced.has_value());
+    EXPECT_EQ(sim.controller().generateStatus()[3]["position"], "Left");
+}
+
+TEST(ControlLoop, ButtonPressOvertakesBulkRequest) {
+    sim::Simulation sim;
+    std::vector<config::SwitchAction> bulk;
+    for (config::ChannelId ch = 0; ch < 6; ch++) {
+        sim.addServo(ch);
+        bulk.push_back(sim::action(ch, SwitchDirection::eRight));
+    }
+    sim.addButton(8, {sim::action(5, SwitchDirection::eRight)});
+    // a single servo moves at a time
+    sim.setPowerBudget(500);
+
+    sim.controller().requestSwitchChange(bulk);
+    sim.advance(10ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+
+    sim.setButton(8, true);
+    auto latency = sim.advanceUntil([&] { return sim.pulseWidth(5) == 1750; }, 2s);
+    ASSERT_TRUE(latency.has_value());
+    // the press only waits for the move in progress
+    EXPECT_LT(*latency, 400ms);
+    EXPECT_EQ(sim.pulseWidth(1), 1300);
+}
+
+TEST(ControlLoop, ButtonPressOvertakesAgedBulkRequest) {
+    sim::Simulation sim;
+    std::vector<config::SwitchAction> bulk;
+    for (config::ChannelId ch = 0; ch < 7; ch++) {
+        sim.addServo(ch, config::MotionProfile::eLinear);
+        bulk.push_back(sim::action(ch, SwitchDirection::eRight));
+    }
+    sim.addServo(7);
+    sim.addButton(8, {sim::action(7, SwitchDirection::eRight)});
+    sim.setPowerBudget(500);
+
+    sim.controller().requestSwitchChange(bulk);
+    // the waiting actions of the bulk request have aged by more than two classes
+    sim.advance(controller::PendingQueue::kAgingStep * 2 + 100ms);
+    ASSERT_EQ(sim.pulseWidth(6), 1300);
+
+    sim.setButton(8, true);
+    auto latency = sim.advanceUntil([&] { return sim.pulseWidth(7) == 1750; }, 5s);
+    ASSERT_TRUE(latency.has_value());
+    EXPECT_LT(*latency, 1s);
+    EXPECT_EQ(sim.pulseWidth(6), 1300);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdarg>
+#include <memory>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "util/DeferredLog.h"
+
+using util::DeferredLog;
+
+namespace {
+void logLine(DeferredLog &log, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    log.write(format, args);
+    va_end(args);
+}
+
+nlohmann::json status(DeferredLog &log, uint32_t since) {
+    std::string out;
+    util::JsonWriter w([&out](const char *data, size_t len) {
+        out.append(data, len);
+        return true;
+    });
+    log.writeStatus(w, since);
+    EXPECT_TRUE(w.flush());
+    return nlohmann::json::parse(out);
+}
+}  // namespace
+
+TEST(DeferredLog, CutsLongLines) {
+    auto log = std::make_unique<DeferredLog>();
+    logLine(*log, "I test: %s\n", std::string(DeferredLog::kLineLength * 2, 'x').c_str());
+    logLine(*log, "I test: %d\n", 42);
+    log->flush();
+
+    auto result = status(*log, 0);
+    EXPECT_EQ(result["truncated"], 1);
+    ASSERT_EQ(result["lines"].size(), 2u);
+    auto cut = result["lines"][0].get<std::string>();
+    EXPECT_EQ(cut.size(), DeferredLog::kLineLength - 1);
+    EXPECT_EQ(cut.back(), '\n');
+    EXPECT_EQ(result["lines"][1], "I test: 42\n");
+}
+
+TEST(DeferredLog, CountsDroppedLines) {
+    auto log = std::make_unique<DeferredLog>();
+    for (size_t i = 0; i < DeferredLog::kQueueSize + 3; i++) {
+        logLine(*log, "I test: %zu\n", i);
+    }
+    EXPECT_EQ(log->dropped(), 3u);
+
+    // the queue takes new lines once it was written
+    log->flush();
+    logLine(*log, "I test: after\n");
+    log->flush();
+    auto result = status(*log, 0);
+    EXPECT_EQ(result["dropped"], 3);
+    EXPECT_EQ(result["next"], DeferredLog::kQueueSize + 1);
+    EXPECT_EQ(result["lines"].back(), "I test: after\n");
+}
+
+TEST(DeferredLog, KeepsLatestLines) {
+    auto log = std::make_unique<DeferredLog>();
+    for (size_t i = 0; i < DeferredLog::kHistorySize + 5; i++) {
+        logLine(*log, "I test: %zu\n", i);
+        log->flush();
+    }
+
+    // older lines are no longer available
+    auto all = status(*log, 0);
+    EXPECT_EQ(all["next"], DeferredLog::kHistorySize + 5);
+    ASSERT_EQ(all["lines"].size(), DeferredLog::kHistorySize);
+    EXPECT_EQ(all["lines"][0], "I test: 5\n");
+
+    // incremental reads continue after the last line
+    auto more = status(*log, DeferredLog::kHistorySize + 3);
+    ASSERT_EQ(more["lines"].size(), 2u);
+    EXPECT_EQ(more["lines"][1], "I test: " + std::to_string(DeferredLog::kHistorySize + 4) + "\n");
+    EXPECT_TRUE(status(*log, all["next"])["lines"].empty());
+}
+
+TEST(DeferredLog, RejectsLevelAboveMaximum) {
+    auto log = std::make_unique<DeferredLog>();
+    EXPECT_NO_THROW(log->setLevel("test", ESP_LOG_WARN));
+    if (CONFIG_LOG_MAXIMUM_LEVEL < ESP_LOG_VERBOSE) {
+        EXPECT_THROW(log->setLevel("test", ESP_LOG_VERBOSE), std::invalid_argument);
+    }
+    EXPECT_EQ(status(*log, 0)["levels"]["test"], "Warn");
+}
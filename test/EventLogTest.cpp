@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "util/EventLog.h"
+
+using util::EventLog;
+using util::EventRecord;
+using util::EventType;
+
+namespace {
+std::vector<EventRecord> readAll(EventLog &log, uint32_t since) {
+    std::vector<EventRecord> records(EventLog::kCapacity);
+    records.resize(log.read(since, records.data(), records.size()));
+    return records;
+}
+}  // namespace
+
+TEST(EventLog, RecordsInOrder) {
+    auto log = std::make_unique<EventLog>();
+    log->begin(1);
+    log->record(EventType::eButtonPress, 8);
+    log->record(EventType::eMoveStarted, 2, 1);
+
+    auto records = readAll(*log, 0);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].type, EventType::eBoot);
+    EXPECT_EQ(records[0].arg, 1);
+    EXPECT_EQ(records[1].type, EventType::eButtonPress);
+    EXPECT_EQ(records[1].channel, 8);
+    EXPECT_EQ(records[2].seq, 2u);
+    EXPECT_EQ(records[2].arg, 1);
+
+    // incremental reads continue after the last event
+    EXPECT_EQ(readAll(*log, 3).size(), 0u);
+    log->record(EventType::eQueued, 3);
+    auto more = readAll(*log, 3);
+    ASSERT_EQ(more.size(), 1u);
+    EXPECT_EQ(more[0].channel, 3);
+}
+
+TEST(EventLog, KeepsLatestEvents) {
+    auto log = std::make_unique<EventLog>();
+    log->begin(1);
+    for (size_t i = 0; i < EventLog::kCapacity * 2; i++) {
+        log->record(EventType::eQueued, static_cast<uint8_t>(i % 16));
+    }
+
+    auto records = readAll(*log, 0);
+    ASSERT_EQ(records.size(), EventLog::kCapacity);
+    EXPECT_EQ(records.front().seq, log->next() - EventLog::kCapacity);
+    EXPECT_EQ(records.back().seq, log->next() - 1);
+}
+
+TEST(EventLog, SurvivesRestart) {
+    auto log = std::make_unique<EventLog>();
+    log->begin(1);
+    log->record(EventType::eButtonPress, 4);
+
+    // a soft reset keeps the memory, a valid log is continued
+    log->begin(3);
+    auto records = readAll(*log, 0);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[1].type, EventType::eButtonPress);
+    EXPECT_EQ(records[2].type, EventType::eBoot);
+    EXPECT_EQ(records[2].arg, 3);
+
+    // a reader from before a power cycle gets everything
+    EXPECT_EQ(readAll(*log, 1000).size(), 3u);
+}
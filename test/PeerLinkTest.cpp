@@ -0,0 +1,260 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "remote/PeerLink.h"
+#include "remote/PeerProtocol.h"
+
+using config::SwitchAction;
+using config::SwitchDirection;
+using remote::MessageType;
+using remote::PeerMessage;
+
+namespace {
+SwitchAction action(config::ChannelId channel, SwitchDirection direction) {
+    SwitchAction a{};
+    a.channel = channel;
+    a.direction = direction;
+    return a;
+}
+
+/**
+ * @brief Stand-in for another board, a plain UDP socket on localhost.
+ */
+class StandInPeer {
+   public:
+    StandInPeer() {
+        fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        timeval tv{1, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    ~StandInPeer() { close(fd_); }
+
+    std::string address() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        return "127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    std::optional<PeerMessage> receive() {
+        std::array<uint8_t, 512> buf{};
+        socklen_t len = sizeof(from_);
+        ssize_t n = recvfrom(fd_, buf.data(), buf.size(), 0, reinterpret_cast<sockaddr *>(&from_), &len);
+        if (n <= 0) {
+            return std::nullopt;
+        }
+        return remote::decodeMessage(buf.data(), n);
+    }
+
+    void sendTo(uint16_t port, const PeerMessage &msg) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        auto data = remote::encodeMessage(msg);
+        sendto(fd_, data.data(), data.size(), 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    }
+
+    /**
+     * @brief Acknowledge the message received last.
+     */
+    void ack(const PeerMessage &msg) {
+        auto data = remote::encodeMessage(PeerMessage{MessageType::eAck, msg.session, msg.sequence, {}});
+        sendto(fd_, data.data(), data.size(), 0, reinterpret_cast<sockaddr *>(&from_), sizeof(from_));
+    }
+
+   private:
+    int fd_;
+    sockaddr_in from_{};
+};
+}  // namespace
+
+TEST(PeerProtocol, RoundTrip) {
+    PeerMessage msg{MessageType::eActions, 42, 7, {action(0, SwitchDirection::eLeft), action(3, SwitchDirection::eRight)}};
+    msg.actions[1].customTime = 1800;
+
+    auto data = remote::encodeMessage(msg);
+    auto decoded = remote::decodeMessage(data.data(), data.size());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->type, MessageType::eActions);
+    EXPECT_EQ(decoded->session, 42u);
+    EXPECT_EQ(decoded->sequence, 7u);
+    ASSERT_EQ(decoded->actions.size(), 2u);
+    EXPECT_EQ(decoded->actions[1].channel, 3);
+    EXPECT_EQ(decoded->actions[1].direction, SwitchDirection::eRight);
+    EXPECT_EQ(decoded->actions[1].customTime, 1800);
+}
+
+TEST(PeerProtocol, RejectsMalformedDatagrams) {
+    auto data = remote::encodeMessage(PeerMessage{MessageType::eActions, 1, 1, {action(0, SwitchDirection::eLeft)}});
+    EXPECT_FALSE(remote::decodeMessage(data.data(), data.size() - 1).has_value());
+
+    auto badMagic = data;
+    badMagic[0] ^= 0xFF;
+    EXPECT_FALSE(remote::decodeMessage(badMagic.data(), badMagic.size()).has_value());
+
+    auto badChannel = data;
+    badChannel[13] = config::kChannelCount;
+    EXPECT_FALSE(remote::decodeMessage(badChannel.data(), badChannel.size()).has_value());
+}
+
+TEST(PeerLink, CoalescesActionsIntoOneDatagram) {
+    StandInPeer peer;
+    remote::PeerLink link(1, 0);
+    ASSERT_TRUE(link.start());
+
+    link.send(peer.address(), {action(0, SwitchDirection::eLeft), action(1, SwitchDirection::eRight),
+                               action(2, SwitchDirection::eLeft)});
+    auto msg = peer.receive();
+    ASSERT_TRUE(msg.has_value());
+    EXPECT_EQ(msg->sequence, 1u);
+    EXPECT_EQ(msg->actions.size(), 3u);
+}
+
+TEST(PeerLink, RetransmitsUntilAcknowledged) {
+    StandInPeer peer;
+    remote::PeerLink link(1, 0);
+    ASSERT_TRUE(link.start());
+
+    link.send(peer.address(), {action(0, SwitchDirection::eLeft)});
+    auto first = peer.receive();
+    ASSERT_TRUE(first.has_value());
+
+    link.poll(remote::PeerLink::kRetransmitInterval + std::chrono::milliseconds(50));
+    auto retransmitted = peer.receive();
+    ASSERT_TRUE(retransmitted.has_value());
+    EXPECT_EQ(retransmitted->sequence, first->sequence);
+    EXPECT_EQ(link.unacked(), 1u);
+
+    peer.ack(*retransmitted);
+    link.poll(std::chrono::milliseconds(100));
+    EXPECT_EQ(link.unacked(), 0u);
+}
+
+TEST(PeerLink, AppliesEachDatagramOnce) {
+    StandInPeer peer;
+    remote::PeerLink link(1, 0);
+    int applied = 0;
+    link.setActionHandler([&applied](const std::vector<SwitchAction> &) {
+        applied++;
+        return true;
+    });
+    ASSERT_TRUE(link.start());
+
+    PeerMessage msg{MessageType::eActions, 99, 1, {action(4, SwitchDirection::eRight)}};
+    for (int i = 0; i < 2; i++) {
+        peer.sendTo(link.localPort(), msg);
+        link.poll(std::chrono::milliseconds(100));
+        auto ack = peer.receive();
+        ASSERT_TRUE(ack.has_value());
+        EXPECT_EQ(ack->type, MessageType::eAck);
+        EXPECT_EQ(ack->sequence, 1u);
+    }
+    EXPECT_EQ(applied, 1);
+}
+
+TEST(PeerLink, AppliesRefusedDatagramAfterLaterOne) {
+    StandInPeer peer;
+    remote::PeerLink link(1, 0);
+    bool accept = false;
+    std::vector<uint32_t> applied;
+    link.setActionHandler([&](const std::vector<SwitchAction> &actions) {
+        if (!accept) {
+            return false;
+        }
+        applied.push_back(actions.front().channel);
+        return true;
+    });
+    ASSERT_TRUE(link.start());
+
+    // the first datagram is refused, e.g. because the command queue is full, and isn't acknowledged
+    PeerMessage first{MessageType::eActions, 99, 1, {action(1, SwitchDirection::eRight)}};
+    peer.sendTo(link.localPort(), first);
+    link.poll(std::chrono::milliseconds(100));
+
+    accept = true;
+    PeerMessage second{MessageType::eActions, 99, 2, {action(2, SwitchDirection::eRight)}};
+    peer.sendTo(link.localPort(), second);
+    link.poll(std::chrono::milliseconds(100));
+    auto ack = peer.receive();
+    ASSERT_TRUE(ack.has_value());
+    EXPECT_EQ(ack->sequence, 2u);
+
+    // the retransmission of the first datagram is applied and not mistaken for a duplicate
+    peer.sendTo(link.localPort(), first);
+    link.poll(std::chrono::milliseconds(100));
+    ack = peer.receive();
+    ASSERT_TRUE(ack.has_value());
+    EXPECT_EQ(ack->sequence, 1u);
+
+    // both are applied once
+    peer.sendTo(link.localPort(), first);
+    peer.sendTo(link.localPort(), second);
+    link.poll(std::chrono::milliseconds(100));
+    EXPECT_EQ(applied, (std::vector<uint32_t>{2, 1}));
+}
+
+TEST(PeerLink, ForgetsSenderHeardLeastRecently) {
+    remote::PeerLink link(1, 0);
+    int applied = 0;
+    link.setActionHandler([&applied](const std::vector<SwitchAction> &) {
+        applied++;
+        return true;
+    });
+    ASSERT_TRUE(link.start());
+
+    std::vector<std::unique_ptr<StandInPeer>> peers;
+    for (size_t i = 0; i <= remote::PeerLink::kMaxSenders; i++) {
+        peers.push_back(std::make_unique<StandInPeer>());
+    }
+    PeerMessage msg{MessageType::eActions, 99, 1, {action(4, SwitchDirection::eRight)}};
+    auto deliver = [&](StandInPeer &peer) {
+        peer.sendTo(link.localPort(), msg);
+        link.poll(std::chrono::milliseconds(50));
+        ASSERT_TRUE(peer.receive().has_value());
+    };
+
+    // fill all windows, the first sender is heard again before the window of another sender is needed
+    for (size_t i = 0; i < remote::PeerLink::kMaxSenders; i++) {
+        deliver(*peers[i]);
+    }
+    deliver(*peers[0]);
+    EXPECT_EQ(applied, static_cast<int>(remote::PeerLink::kMaxSenders));
+
+    // the second sender is forgotten, its retransmission is applied again
+    deliver(*peers.back());
+    deliver(*peers[0]);
+    EXPECT_EQ(applied, static_cast<int>(remote::PeerLink::kMaxSenders) + 1);
+    deliver(*peers[1]);
+    EXPECT_EQ(applied, static_cast<int>(remote::PeerLink::kMaxSenders) + 2);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "controller/PendingQueue.h"
+
+using controller::PendingQueue;
+using controller::Priority;
+using namespace std::chrono_literals;
+
+namespace {
+std::vector<config::ChannelId> order(const PendingQueue &queue, std::chrono::steady_clock::time_point now) {
+    std::array<config::ChannelId, config::kChannelCount> channels{};
+    size_t count = queue.order(now, channels);
+    return {channels.begin(), channels.begin() + count};
+}
+}  // namespace
+
+TEST(PendingQueue, HigherClassFirst) {
+    PendingQueue queue;
+    auto now = std::chrono::steady_clock::time_point{};
+    queue.push(0, Priority::eRemote, queue.newGroup(), now);
+    queue.push(1, Priority::eLocal, queue.newGroup(), now);
+    queue.push(2, Priority::eManual, queue.newGroup(), now);
+    EXPECT_EQ(order(queue, now), (std::vector<config::ChannelId>{2, 1, 0}));
+}
+
+TEST(PendingQueue, RequestsStayTogether) {
+    PendingQueue queue;
+    auto now = std::chrono::steady_clock::time_point{};
+    auto first = queue.newGroup();
+    auto second = queue.newGroup();
+    queue.push(5, Priority::eRemote, first, now);
+    queue.push(1, Priority::eRemote, second, now);
+    queue.push(3, Priority::eRemote, first, now);
+    EXPECT_EQ(order(queue, now), (std::vector<config::ChannelId>{3, 5, 1}));
+}
+
+TEST(PendingQueue, ReplacingKeepsOneEntry) {
+    PendingQueue queue;
+    auto now = std::chrono::steady_clock::time_point{};
+    queue.push(4, Priority::eRemote, queue.newGroup(), now);
+    queue.push(4, Priority::eManual, queue.newGroup(), now);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_EQ(queue.find(4)->priority, Priority::eManual);
+
+    auto entry = queue.take(4);
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_FALSE(queue.take(4).has_value());
+}
+
+TEST(PendingQueue, WaitingActionsAge) {
+    PendingQueue queue;
+    auto start = std::chrono::steady_clock::time_point{};
+    queue.push(0, Priority::eRemote, queue.newGroup(), start);
+    queue.push(1, Priority::eLocal, queue.newGroup(), start + 500ms);
+    EXPECT_EQ(order(queue, start + 500ms), (std::vector<config::ChannelId>{1, 0}));
+    // promoted by one class, the older request goes first
+    EXPECT_EQ(order(queue, start + PendingQueue::kAgingStep), (std::vector<config::ChannelId>{0, 1}));
+}
+
+TEST(PendingQueue, NothingAgesPastManual) {
+    PendingQueue queue;
+    auto start = std::chrono::steady_clock::time_point{};
+    auto bulk = queue.newGroup();
+    for (config::ChannelId ch = 1; ch < 8; ch++) {
+        queue.push(ch, Priority::eRemote, bulk, start);
+    }
+    queue.push(0, Priority::eManual, queue.newGroup(), start + 5s);
+    EXPECT_EQ(order(queue, start + 5s), (std::vector<config::ChannelId>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "controller/RouteTracker.h"
+
+using controller::RouteState;
+using controller::RouteTracker;
+
+TEST(RouteTracker, OutOfOrderRoutesAreTracked) {
+    RouteTracker tracker;
+    tracker.begin(6);
+    EXPECT_EQ(tracker.find(5)->state(), RouteState::ePending);
+    EXPECT_EQ(tracker.find(6)->state(), RouteState::eDone);
+
+    tracker.begin(5);
+    tracker.addMove(5);
+    EXPECT_EQ(tracker.find(5)->state(), RouteState::ePending);
+    EXPECT_EQ(tracker.find(6)->state(), RouteState::eDone);
+}
+
+TEST(RouteTracker, UnhandledRouteIsQueued) {
+    RouteTracker tracker;
+    tracker.begin(1);
+    auto status = tracker.find(2);
+    ASSERT_TRUE(status.has_value());
+    EXPECT_TRUE(status->queued);
+}
+
+TEST(RouteTracker, OldRoutesAreForgotten) {
+    RouteTracker tracker;
+    tracker.begin(1);
+    tracker.begin(1 + RouteTracker::kMaxRoutes);
+    EXPECT_FALSE(tracker.find(1).has_value());
+
+    // a late route doesn't replace the newer one sharing its slot
+    tracker.begin(1);
+    EXPECT_FALSE(tracker.find(1).has_value());
+    EXPECT_TRUE(tracker.find(1 + RouteTracker::kMaxRoutes).has_value());
+}
+
+TEST(RouteTracker, ForwardedRouteIsNotDone) {
+    RouteTracker tracker;
+    tracker.begin(1);
+    tracker.markForwarded(1);
+    EXPECT_EQ(tracker.find(1)->state(), RouteState::eForwarded);
+
+    // a failed forward still rejects the route
+    tracker.reject(1);
+    EXPECT_EQ(tracker.find(1)->state(), RouteState::eRejected);
+}
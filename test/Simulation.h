@@ -0,0 +1,181 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SWITCHCONTROL_TEST_SIMULATION_H
+#define SWITCHCONTROL_TEST_SIMULATION_H
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "controller/OperationController.h"
+#include "hal/Sim.h"
+
+namespace sim {
+using namespace std::chrono_literals;
+
+inline config::SwitchAction action(config::ChannelId channel, config::SwitchDirection direction) {
+    config::SwitchAction a{};
+    a.channel = channel;
+    a.direction = direction;
+    return a;
+}
+
+/**
+ * @brief Runs the controller on simulated io with virtual time.
+ * Each step advances the clock by one millisecond and ticks the controller, the buttons are sampled with the period
+ * of the sampling task. Runs are deterministic since nothing depends on the wall clock.
+ */
+class Simulation {
+   public:
+    static constexpr std::chrono::milliseconds kStep{1};
+
+    Simulation() = default;
+
+    OperationController &controller() { return ctrl_; }
+    [[nodiscard]] std::chrono::milliseconds elapsed() const { return elapsed_; }
+    [[nodiscard]] size_t pwmWrites() const { return pwm_.writes(); }
+
+    void addServo(config::ChannelId channel, config::MotionProfile profile = config::MotionProfile::eNone) {
+        config::ConfigServo servo{};
+        servo.motionProfile = profile;
+        addServo(channel, servo);
+    }
+
+    /**
+     * @brief Add a servo. Unless another position was restored, the servo starts in the left position as after a
+     * restart with saved positions.
+     */
+    void addServo(config::ChannelId channel, const config::ConfigServo &servo) {
+        if (!restored_[channel].has_value()) {
+            restorePosition(channel, {config::SwitchDirection::eLeft, 0});
+        }
+        config::ConfigGpio cfg{};
+        cfg.channel = channel;
+        cfg.type = config::ChannelType::eServo;
+        cfg.servoCfg_ = servo;
+        ctrl_.updateChannel(cfg);
+        ctrl_.tick();
+    }
+
+    /**
+     * @brief Set the position a servo starts in when it is added, an unknown position makes it resynchronize.
+     */
+    void restorePosition(config::ChannelId channel, config::ServoPosition position) {
+        restored_[channel] = position;
+        config::ServoPositions positions{};
+        for (size_t ch = 0; ch < positions.size(); ch++) {
+            positions[ch] = restored_[ch].value_or(config::ServoPosition{});
+        }
+        ctrl_.restorePositions(positions);
+        ctrl_.tick();
+    }
+
+    void addButton(config::ChannelId channel, std::vector<config::SwitchAction> actions) {
+        config::ConfigGpio cfg{};
+        cfg.channel = channel;
+        cfg.type = config::ChannelType::eSmartButton;
+        cfg.buttonCfg_ = config::ConfigButton{true, true, std::move(actions), ""};
+        ctrl_.updateChannel(cfg);
+        ctrl_.tick();
+    }
+
+    void setPowerBudget(int budget) {
+        config::PowerConfig cfg{};
+        cfg.rails[0].budget = budget;
+        ctrl_.setPowerConfig(cfg);
+        ctrl_.tick();
+    }
+
+    /**
+     * @brief Press or release a button, a pressed button pulls its pin low.
+     */
+    void setButton(config::ChannelId channel, bool pressed) { gpio_.setInput(config::kChannels[channel].gpio, !pressed); }
+
+    /**
+     * @brief Set the reading of an ADC channel used as sense input.
+     */
+    void setSenseInput(int adcChannel, int millivolts) { adc_.setMillivolts(adcChannel, millivolts); }
+
+    [[nodiscard]] int pulseWidth(config::ChannelId channel) const {
+        return pwm_.pulseWidth(config::kChannels[channel].ledc);
+    }
+
+    void step() {
+        clock_.advance(kStep);
+        elapsed_ += kStep;
+        if (elapsed_.count() % io::ButtonSampler::kSamplePeriodMs == 0) {
+            ctrl_.sampleButtons();
+        }
+        if (elapsed_.count() % io::SenseSampler::kSamplePeriodMs == 0) {
+            ctrl_.sampleSense();
+        }
+        ctrl_.tick();
+    }
+
+    void advance(std::chrono::milliseconds duration) {
+        for (auto end = elapsed_ + duration; elapsed_ < end;) {
+            step();
+        }
+    }
+
+    /**
+     * @brief Advance until a condition holds.
+     * @return the time it took or nothing if the condition didn't hold within the limit
+     */
+    template <typename Predicate>
+    std::optional<std::chrono::milliseconds> advanceUntil(Predicate predicate, std::chrono::milliseconds limit) {
+        auto start = elapsed_;
+        while (!predicate()) {
+            if (elapsed_ - start >= limit) {
+                return std::nullopt;
+            }
+            step();
+        }
+        return elapsed_ - start;
+    }
+
+   private:
+    /**
+     * @brief Installs the simulated backends before the controller is created.
+     */
+    struct Backends {
+        Backends(hal::SimClock &clock, hal::SimPwm &pwm, hal::SimGpio &gpio, hal::SimAdc &adc) {
+            hal::Clock::setBackend(&clock);
+            hal::setBackends(&pwm, &gpio, &adc);
+        }
+        ~Backends() {
+            hal::Clock::setBackend(nullptr);
+            hal::setBackends(nullptr, nullptr, nullptr);
+        }
+    };
+
+    hal::SimClock clock_;
+    hal::SimPwm pwm_;
+    hal::SimGpio gpio_;
+    hal::SimAdc adc_;
+    Backends backends_{clock_, pwm_, gpio_, adc_};
+    OperationController ctrl_;
+    std::array<std::optional<config::ServoPosition>, config::kChannelCount> restored_{};
+    std::chrono::milliseconds elapsed_{0};
+};
+}  // namespace sim
+
+#endif  // SWITCHCONTROL_TEST_SIMULATION_H
@@ -0,0 +1,158 @@
+/*
+ * Copyright © 2024 Johannes Zangl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the “Software”), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Simulation.h"
+
+using config::SwitchDirection;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr int kAdcChannel = 3;
+
+config::ConfigServo senseServo(config::SenseMode mode) {
+    config::ConfigServo cfg{};
+    cfg.overdrawTime = 1.0;
+    cfg.sense = mode;
+    cfg.senseChannel = kAdcChannel;
+    cfg.senseThreshold = 500;
+    cfg.senseLeft = 400;
+    cfg.senseRight = 2400;
+    return cfg;
+}
+
+nlohmann::json channelStatus(sim::Simulation &sim, config::ChannelId channel) {
+    for (const auto &ch : sim.controller().generateStatus()) {
+        if (ch.value("channel", "") == config::channelName(channel)) {
+            return ch;
+        }
+    }
+    return {};
+}
+}  // namespace
+
+TEST(StallDetection, StallEndsOverdraw) {
+    sim::Simulation sim;
+    sim.addServo(0, senseServo(config::SenseMode::eCurrent));
+
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(100ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+
+    // the servo hits its end stop
+    sim.setSenseInput(kAdcChannel, 800);
+    auto settled = sim.advanceUntil([&] { return sim.pulseWidth(0) == 1700; }, 1s);
+    ASSERT_TRUE(settled.has_value());
+    EXPECT_LE(*settled, std::chrono::milliseconds(io::SenseSampler::kSamplePeriodMs *
+                                                  (io::SenseSampler::kRequiredSamples + 1)));
+
+    auto status = channelStatus(sim, 0);
+    EXPECT_EQ(status["settledBy"], "Stall");
+    EXPECT_EQ(status["stalls"], 1);
+    EXPECT_LT(status["moveDuration"].get<int>(), 200);
+}
+
+TEST(StallDetection, TimeoutWithoutStall) {
+    sim::Simulation sim;
+    sim.addServo(0, senseServo(config::SenseMode::eCurrent));
+
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(900ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+    sim.advance(200ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1700);
+
+    auto status = channelStatus(sim, 0);
+    EXPECT_EQ(status["settledBy"], "Timeout");
+    EXPECT_EQ(status["stalls"], 0);
+}
+
+TEST(StallDetection, InrushIsBlanked) {
+    sim::Simulation sim;
+    sim.addServo(0, senseServo(config::SenseMode::eCurrent));
+
+    // the inrush current reads like a stall, it is gone before the blanking time ends
+    sim.setSenseInput(kAdcChannel, 800);
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(std::chrono::milliseconds(io::SenseSampler::kBlankingMs - 10));
+    sim.setSenseInput(kAdcChannel, 100);
+    sim.advance(500ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+}
+
+TEST(StallDetection, PositionFeedbackSettles) {
+    sim::Simulation sim;
+    sim.addServo(0, senseServo(config::SenseMode::ePosition));
+    sim.setSenseInput(kAdcChannel, 400);
+
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(100ms);
+    EXPECT_EQ(sim.pulseWidth(0), 1750);
+
+    // within the tolerance around the right position
+    sim.setSenseInput(kAdcChannel, 2200);
+    auto settled = sim.advanceUntil([&] { return sim.pulseWidth(0) == 1700; }, 1s);
+    ASSERT_TRUE(settled.has_value());
+    EXPECT_EQ(channelStatus(sim, 0)["settledBy"], "InPosition");
+}
+
+TEST(StallDetection, StallFreesBudgetForPendingMoves) {
+    sim::Simulation sim;
+    sim.addServo(0, senseServo(config::SenseMode::eCurrent));
+    sim.addServo(1);
+    sim.setPowerBudget(500);
+
+    auto route = sim.controller().requestSwitchChange(
+        {sim::action(0, SwitchDirection::eRight), sim::action(1, SwitchDirection::eRight)});
+    sim.advance(100ms);
+    EXPECT_EQ(sim.pulseWidth(1), 1300);
+
+    sim.setSenseInput(kAdcChannel, 800);
+    auto started = sim.advanceUntil([&] { return sim.pulseWidth(1) == 1750; }, 2s);
+    ASSERT_TRUE(started.has_value());
+    EXPECT_LT(*started, 100ms);
+
+    auto done = sim.advanceUntil(
+        [&] { return sim.controller().getRouteStatus(route)->state() == controller::RouteState::eDone; }, 2s);
+    ASSERT_TRUE(done.has_value());
+    // the second servo runs its full move of 0.3 s, the first one would have taken 1 s alone
+    EXPECT_LT(sim.elapsed(), 700ms);
+}
+
+TEST(StallDetection, RampIsNotCutShort) {
+    sim::Simulation sim;
+    config::ConfigServo cfg = senseServo(config::SenseMode::eCurrent);
+    cfg.motionProfile = config::MotionProfile::eLinear;
+    sim.addServo(0, cfg);
+
+    // ramps from 1300 us to 1750 us in 450 ms, a current spike during the ramp doesn't end the overdraw
+    sim.controller().requestSwitchChange({sim::action(0, SwitchDirection::eRight)});
+    sim.advance(100ms);
+    sim.setSenseInput(kAdcChannel, 800);
+    sim.advance(200ms);
+    EXPECT_GT(sim.pulseWidth(0), 1300);
+    EXPECT_LT(sim.pulseWidth(0), 1750);
+
+    // the stall is only detected once the ramp reached the overdraw position
+    auto settled = sim.advanceUntil([&] { return sim.pulseWidth(0) == 1700; }, 1s);
+    ASSERT_TRUE(settled.has_value());
+    EXPECT_EQ(channelStatus(sim, 0)["settledBy"], "Stall");
+    EXPECT_GE(channelStatus(sim, 0)["moveDuration"].get<int>(), 450);
+}
@@ -5,9 +5,6 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
-TEST(Todotest, FooBar) {
-}
-
 namespace {
     int argc;
     char **argv;
@@ -30,7 +30,11 @@ const initialConfigs = layout.map(l => ({
         posRight: 1700,
         posLeftOverdraw: 1250,
         posRightOverdraw: 1750,
-        overdrawTime: 1
+        overdrawTime: 1,
+        rail: 0,
+        inrushCurrent: 500,
+        motionProfile: 'None',
+        speed: 1000
     },
     button: {
         invertedInput: false,
@@ -8,6 +8,26 @@ import Components from 'unplugin-vue-components/vite'
 import IconsResolve from 'unplugin-icons/resolver'
 import VieI18nPlugin from '@intlify/unplugin-vue-i18n/vite'
 import {resolve, dirname} from 'node:path'
+import {readFileSync, writeFileSync} from 'node:fs'
+import {gzipSync, constants} from 'node:zlib'
+
+// Store gzip compressed copies of the files embedded into the firmware, they are served to all clients accepting it.
+function precompress(files) {
+    let outDir;
+    return {
+        name: 'precompress',
+        apply: 'build',
+        configResolved(config) {
+            outDir = resolve(config.root, config.build.outDir);
+        },
+        closeBundle() {
+            for (const file of files) {
+                const path = resolve(outDir, file);
+                writeFileSync(path + '.gz', gzipSync(readFileSync(path), {level: constants.Z_BEST_COMPRESSION}));
+            }
+        }
+    }
+}
 
 // https://vitejs.dev/config/
 export default defineConfig(({mode}) => {
@@ -18,6 +38,7 @@ export default defineConfig(({mode}) => {
         plugins: [
             vue(),
             !isDemo && viteSingleFile(),
+            !isDemo && precompress(['index.html', 'favicon.ico']),
             Components({
                 resolvers: [IconsResolve()],
                 dts: true,